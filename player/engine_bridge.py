@@ -8,6 +8,7 @@ class Engine:
             [path], stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True, bufsize=1
         )
         self.outq = queue.Queue()
+        self.pondering = False
         threading.Thread(target=self._reader, daemon=True).start()
 
     def _reader(self):
@@ -25,9 +26,30 @@ class Engine:
         while True:
             line = self.outq.get()
             if line.startswith("bestmove"):
-                # e.g., "bestmove e2e4 score 34"
+                # e.g., "bestmove e2e4 ponder e7e5 score 34"
                 toks = line.split()
                 best["move"] = toks[1]
+                if "ponder" in toks:
+                    best["ponder"] = toks[toks.index("ponder") + 1]
                 if "score" in toks:
                     best["score"] = toks[toks.index("score") + 1]
                 return best
+
+    def ponder(self, fen: str, moves: list, depth: int):
+        # Thinks on the opponent's time: fen followed by our move and the
+        # reply we expect. The engine also searches a few other likely
+        # replies, so whichever is played our next search starts warm.
+        self.p.stdin.write(f"position {fen} moves {' '.join(moves)}\n")
+        self.p.stdin.write(f"go ponder depth {depth}\n")
+        self.p.stdin.flush()
+        self.pondering = True
+
+    def stop_ponder(self):
+        # The answer to a stopped ponder search is not to be played
+        if not self.pondering:
+            return
+        self.p.stdin.write("stop\n")
+        self.p.stdin.flush()
+        while not self.outq.get().startswith("bestmove"):
+            pass
+        self.pondering = False
@@ -23,13 +23,18 @@ def main():
             prev = cur
             continue
 
-        # Our turn
+        # Our turn. Whatever the opponent played, pondering has left the
+        # answers to its likely replies in the engine's hash table.
+        eng.stop_ponder()
         fen = to_fen(cur)  # your variant FEN
         eng.position(fen)
-        bm = eng.go(SEARCH_DEPTH)["move"]  # "e2e4", "N@f3", "e1g1", "e7e8q", ...
+        best = eng.go(SEARCH_DEPTH)
+        bm = best["move"]  # "e2e4", "N@f3", "e1g1", "e7e8q", ...
 
         execute_ui_move(bm, sr.board_to_pixels)  # clicks
         time.sleep(0.15)
+        if "ponder" in best:
+            eng.ponder(fen, [bm, best["ponder"]], SEARCH_DEPTH)
         # Verify board changed accordingly
         prev = sr.read_boardstate()
 
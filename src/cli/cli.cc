@@ -1,15 +1,27 @@
 // cli.cc
 // Minimal CLI dispatcher: only two modes.
-//   tinyhouse solve --out <file>
+//   tinyhouse solve --out <file> [--threads <N>] [--max-mem <GB>]
+//                   [--checkpoint <dir> | --resume <dir>] [--stats <file>]
+//                   [--mphf <bits>]
 //   tinyhouse play --tb <file>
 
-#include "..\solve\solve.h"
+#include "../solve/solve.h"
 
+#include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "../core/bitboard.h"
+#include "../core/perft.h"
+#include "../core/position.h"
+#include "../solve/tb_read.h"
+
+using namespace tiny;
+
 namespace
 {
 
@@ -22,13 +34,25 @@ namespace
 Commands:
 
   solve
-    --out <path>   (required) output tablebase file
+    --out <path>   (required) output tablebase file; a WDL bitbase for the
+                   engine is written to <path>.wdl
+    --threads <N>  threads expanding positions (default 1)
+    --max-mem <GB> keep node data in scratch files next to the output and
+                   page it out to stay within this much memory
+    --checkpoint <dir>
+                   save the solver state to dir after the forward phase and
+                   every 10 minutes
+    --resume <dir> as --checkpoint, but first go on from the state in dir
+    --stats <file> keep progress figures in a JSON file, updated every 10 s
+    --mphf <bits>  index the tablebase by a perfect hash and store no keys,
+                   keeping bits (0 to 32) of each key to reject positions
+                   that are not in it
 
   play
     --tb <path>    (required) load tablebase file
 
 Examples:
-  tinyhouse solve --out tinyhouse.tb
+  tinyhouse solve --out tinyhouse.tb --threads 4
   tinyhouse play --tb tinyhouse.tb
 )" << std::endl;
     }
@@ -36,18 +60,36 @@ Examples:
     void print_play_repl_help()
     {
         std::cout <<
-            R"(REPL commands (stubs):
+            R"(REPL commands:
   startpos
   position thfen <string>
   bestmove
-  perft <N>
+  perft <N> [threads <T>] [hash <MB>]
   d
   quit
 )" << std::endl;
     }
 
-    // ----- Command runners (stubs) -----
-    int run_solve(const std::string &out_path)
+    const char *wdl_name(retro::WDL wdl)
+    {
+        return wdl == retro::WDL::Win ? "win" : wdl == retro::WDL::Loss ? "loss" : "draw";
+    }
+
+    // Prints the tablebase verdict for pos, from the side to move
+    void print_tb_result(const tb::Reader &tb, const Position &pos)
+    {
+        retro::TBRecord rec;
+        if (!tb.probe(pos, rec))
+            std::cout << "tb: position not in tablebase\n";
+        else if (rec.wdl == retro::WDL::Draw)
+            std::cout << "tb: draw\n";
+        else
+            std::cout << "tb: " << wdl_name(rec.wdl) << " in " << rec.dtm << " plies\n";
+    }
+
+    // ----- Command runners -----
+    int run_solve(const std::string &out_path, const retro::SolveOptions &options,
+                  const tb::WriteOptions &format)
     {
         if (out_path.empty())
         {
@@ -55,7 +97,7 @@ Examples:
             return 2;
         }
         std::cout << "[solve] out=" << out_path << "\n";
-        return solve(out_path);
+        return solve(out_path, options, format);
     }
 
     int run_play(const std::string &tb_path)
@@ -66,9 +108,20 @@ Examples:
             return 2;
         }
         std::cout << "[play] tb=" << tb_path << "\n";
-        std::cout << "TODO: engine not implemented. Entering stub REPL.\n";
+
+        tb::Reader tb;
+        if (int rc = tb.open(tb_path))
+        {
+            std::cerr << "error: cannot load tablebase '" << tb_path << "' (rc=" << rc << ")\n";
+            return 1;
+        }
+        std::cout << "[play] " << tb.size() << " positions\n";
         print_play_repl_help();
 
+        Position pos;
+        std::deque<StateInfo> states(1);
+        pos.set(StartFEN, &states.back());
+
         std::string line;
         std::cout << "tinyhouse> " << std::flush;
         while (std::getline(std::cin, line))
@@ -78,15 +131,47 @@ Examples:
             else if (line == "help" || line == "?")
                 print_play_repl_help();
             else if (line == "startpos")
-                std::cout << "(startpos) OK [stub]\n";
-            else if (line.rfind("position", 0) == 0)
-                std::cout << "(position) OK [stub]\n";
+            {
+                states.assign(1, StateInfo());
+                pos.set(StartFEN, &states.back());
+                std::cout << "(startpos) OK\n";
+                print_tb_result(tb, pos);
+            }
+            else if (line.rfind("position thfen ", 0) == 0)
+            {
+                states.assign(1, StateInfo());
+                pos.set(line.substr(std::strlen("position thfen ")), &states.back());
+                std::cout << "(position) OK\n";
+                print_tb_result(tb, pos);
+            }
             else if (line == "bestmove")
-                std::cout << "bestmove (unimplemented)\n";
+            {
+                retro::TBRecord rec;
+                Move m = tb.best_move(pos, rec);
+                if (m)
+                    std::cout << "bestmove " << to_string(m) << "\n";
+                else
+                    std::cout << "bestmove none\n";
+                print_tb_result(tb, pos);
+            }
             else if (line.rfind("perft", 0) == 0)
-                std::cout << "(perft) = 0 [stub]\n";
+            {
+                std::istringstream is(line.substr(5));
+                std::string token;
+                int depth = 1;
+                size_t threads = 1, hashMB = 0;
+
+                is >> depth;
+                while (is >> token)
+                    if (token == "threads")
+                        is >> threads;
+                    else if (token == "hash")
+                        is >> hashMB;
+
+                Perft::run(pos, depth, threads, hashMB);
+            }
             else if (line == "d")
-                std::cout << "(display) [stub]\n";
+                std::cout << pos << "\n" << pos.fen() << "\n";
             else if (line.empty())
             { /* ignore */
             }
@@ -100,13 +185,48 @@ Examples:
 
     int cmd_solve(int argc, char **argv)
     {
-        if (argc != 2 || std::strcmp(argv[0], "--out") != 0)
+        std::string out_path;
+        retro::SolveOptions options;
+        tb::WriteOptions format;
+        double maxMemGB = 0;
+
+        for (int i = 0; i + 1 < argc; i += 2)
         {
-            std::cerr << "usage: tinyhouse solve --out <path>\n";
+            if (std::strcmp(argv[i], "--out") == 0)
+                out_path = argv[i + 1];
+            else if (std::strcmp(argv[i], "--threads") == 0)
+                options.threads = std::strtoul(argv[i + 1], nullptr, 10);
+            else if (std::strcmp(argv[i], "--max-mem") == 0)
+                maxMemGB = std::strtod(argv[i + 1], nullptr);
+            else if (std::strcmp(argv[i], "--checkpoint") == 0 ||
+                     std::strcmp(argv[i], "--resume") == 0)
+            {
+                options.checkpointDir = argv[i + 1];
+                options.resume = std::strcmp(argv[i], "--resume") == 0;
+            }
+            else if (std::strcmp(argv[i], "--stats") == 0)
+                options.statsPath = argv[i + 1];
+            else if (std::strcmp(argv[i], "--mphf") == 0)
+            {
+                format.mphf = true;
+                format.fingerprintBits = std::atoi(argv[i + 1]);
+            }
+            else
+                argc = -1;
+        }
+
+        if (argc % 2 != 0 || out_path.empty() || options.threads == 0 || maxMemGB < 0 ||
+            format.fingerprintBits < 0 || format.fingerprintBits > 32)
+        {
+            std::cerr << "usage: tinyhouse solve --out <path> [--threads <N>] [--max-mem <GB>]\n"
+                         "                       [--checkpoint <dir> | --resume <dir>]\n"
+                         "                       [--stats <file>] [--mphf <bits>]\n";
             return 2;
         }
-        std::string out_path = argv[1];
-        return run_solve(out_path);
+
+        options.maxMemory = size_t(maxMemGB * (1ULL << 30));
+        options.scratchPrefix = out_path;
+        return run_solve(out_path, options, format);
     }
 
     int cmd_play(int argc, char **argv)
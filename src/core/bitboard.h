@@ -4,11 +4,13 @@
 #define BITBOARD_H_INCLUDED
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <initializer_list>
 #include <string>
 
 #include "types.h"
@@ -17,7 +19,6 @@ namespace tiny {
 
 namespace Bitboards {
 
-void        init();
 std::string pretty(Bitboard b);
 
 }  // namespace Bitboards
@@ -32,13 +33,6 @@ constexpr Bitboard Rank2BB = Rank1BB << (4 * 1);
 constexpr Bitboard Rank3BB = Rank1BB << (4 * 2);
 constexpr Bitboard Rank4BB = Rank1BB << (4 * 3);
 
-extern uint8_t PopCnt16[1 << 16];
-extern uint8_t SquareDistance[SQUARE_NB][SQUARE_NB];
-
-extern Bitboard PseudoAttacks[PIECE_TYPE_NB][SQUARE_NB];
-extern Bitboard HorseAttacks[4][SQUARE_NB];
-extern Square   HorseLegSquare[4][SQUARE_NB];
-
 constexpr Bitboard square_bb(Square s) {
     assert(is_ok(s));
     return (1u << s);
@@ -85,17 +79,167 @@ constexpr Bitboard pawn_attacks_bb(Bitboard b) {
                       : shift<SOUTH_WEST>(b) | shift<SOUTH_EAST>(b);
 }
 
-inline Bitboard horse_leg_bb(Square from, Square to) {
-    assert(is_ok(from) && is_ok(to));
+// The horse tables are indexed by the occupancy of four squares around s,
+// gathered into 4 bits without branches. The board is padded so that the
+// neighbours of edge squares never shift out of range; the bits read for
+// off-board neighbours are meaningless but the tables do not depend on them.
+//
+// Leg index: the orthogonal neighbours (N, E, S, W), which decide where a
+// horse on s can go.
+constexpr unsigned horse_leg_index(Square s, Bitboard occupied) {
+    const uint32_t o = uint32_t(occupied) << 4;
+    return ((o >> (s + 8)) & 1) | ((o >> (s + 5)) & 1) << 1 | ((o >> s) & 1) << 2 |
+           ((o >> (s + 3)) & 1) << 3;
+}
+
+// Attacker index: the diagonal neighbours (NE, NW, SE, SW), which hold the
+// legs of every horse that could attack s.
+constexpr unsigned horse_attacker_index(Square s, Bitboard occupied) {
+    const uint32_t o = uint32_t(occupied) << 5;
+    return ((o >> (s + 10)) & 1) | ((o >> (s + 8)) & 1) << 1 | ((o >> (s + 2)) & 1) << 2 |
+           ((o >> s) & 1) << 3;
+}
+
+// The tables below are computed at compile time, so they need no start-up
+// code and live in read-only data, shared by every process using them.
+namespace Bitboards {
+
+template <typename T, size_t N, size_t M>
+using Table = std::array<std::array<T, M>, N>;
+
+constexpr std::array<uint8_t, 1 << 16> popcnt16() {
+    std::array<uint8_t, 1 << 16> t{};
+    for (unsigned i = 1; i < t.size(); ++i) t[i] = uint8_t(t[i >> 1] + (i & 1));
+    return t;
+}
+
+constexpr int king_distance(Square x, Square y) {
+    const int f = file_of(x) - file_of(y), r = rank_of(x) - rank_of(y);
+    return std::max(f < 0 ? -f : f, r < 0 ? -r : r);
+}
+
+constexpr Table<uint8_t, SQUARE_NB, SQUARE_NB> square_distance() {
+    Table<uint8_t, SQUARE_NB, SQUARE_NB> t{};
+    for (Square s1 = SQ_A1; s1 <= SQ_D4; ++s1)
+        for (Square s2 = SQ_A1; s2 <= SQ_D4; ++s2) t[s1][s2] = uint8_t(king_distance(s1, s2));
+    return t;
+}
+
+// Returns the bitboard of target square for the given step
+// from the given square. If the step is off the board, returns empty bitboard.
+constexpr Bitboard safe_destination(Square s, int step) {
+    const Square to = Square(s + step);
+    return is_ok(to) && king_distance(s, to) <= 2 ? square_bb(to) : Bitboard(0);
+}
+
+// The squares next to s in each direction, which a horse steps over first
+constexpr Table<Square, DIR_NB, SQUARE_NB> horse_leg_squares() {
+    Table<Square, DIR_NB, SQUARE_NB> t{};
+    for (Square s = SQ_A1; s <= SQ_D4; ++s) {
+        const Bitboard legs[DIR_NB] = {shift<NORTH>(square_bb(s)), shift<EAST>(square_bb(s)),
+                                       shift<SOUTH>(square_bb(s)), shift<WEST>(square_bb(s))};
+        const Direction steps[DIR_NB] = {NORTH, EAST, SOUTH, WEST};
+        for (int d = DIR_N; d < DIR_NB; ++d) t[d][s] = legs[d] ? Square(s + steps[d]) : SQ_NONE;
+    }
+    return t;
+}
+
+// From the leg square, a horse moves diagonally away from the leg direction
+constexpr Table<Bitboard, DIR_NB, SQUARE_NB> horse_attacks() {
+    Table<Bitboard, DIR_NB, SQUARE_NB> t{};
+    for (Square s = SQ_A1; s <= SQ_D4; ++s) {
+        const Bitboard n = shift<NORTH>(square_bb(s)), e = shift<EAST>(square_bb(s));
+        const Bitboard so = shift<SOUTH>(square_bb(s)), w = shift<WEST>(square_bb(s));
+        t[DIR_N][s] = shift<NORTH_EAST>(n) | shift<NORTH_WEST>(n);
+        t[DIR_E][s] = shift<NORTH_EAST>(e) | shift<SOUTH_EAST>(e);
+        t[DIR_S][s] = shift<SOUTH_EAST>(so) | shift<SOUTH_WEST>(so);
+        t[DIR_W][s] = shift<SOUTH_WEST>(w) | shift<NORTH_WEST>(w);
+    }
+    return t;
+}
+
+constexpr Table<Bitboard, PIECE_TYPE_NB, SQUARE_NB> pseudo_attacks() {
+    Table<Bitboard, PIECE_TYPE_NB, SQUARE_NB> t{};
+    const auto horse = horse_attacks();
 
-    // Find which leg direction produces 'to' from 'from'
-    for (int d = DIR_N; d < DIR_NB; ++d) {
-        Square leg = HorseLegSquare[d][from];
-        if (!is_ok(leg)) continue;
+    for (Square s = SQ_A1; s <= SQ_D4; ++s) {
+        t[WHITE][s] = pawn_attacks_bb<WHITE>(square_bb(s));
+        t[BLACK][s] = pawn_attacks_bb<BLACK>(square_bb(s));
 
-        if (HorseAttacks[d][from] & square_bb(to)) return square_bb(leg);
+        for (int step : {NORTH, NORTH_EAST, EAST, SOUTH_EAST, SOUTH, SOUTH_WEST, WEST, NORTH_WEST})
+            t[KING][s] |= safe_destination(s, step);
+
+        for (int step : {NORTH, EAST, SOUTH, WEST}) t[WAZIR][s] |= safe_destination(s, step);
+
+        for (int step : {NORTH_EAST, SOUTH_EAST, SOUTH_WEST, NORTH_WEST})
+            t[FERZ][s] |= safe_destination(s, step);
+
+        for (int d = DIR_N; d < DIR_NB; ++d) t[HORSE][s] |= horse[d][s];
     }
-    return Bitboard(0);  // Defensive: shouldn't be reached if tables are consistent
+    return t;
+}
+
+// The leg square between a horse on s1 and each square s2 it can reach
+constexpr Table<Bitboard, SQUARE_NB, SQUARE_NB> horse_leg_bbs() {
+    Table<Bitboard, SQUARE_NB, SQUARE_NB> t{};
+    const auto legs = horse_leg_squares();
+    const auto horse = horse_attacks();
+
+    for (Square s1 = SQ_A1; s1 <= SQ_D4; ++s1)
+        for (int d = DIR_N; d < DIR_NB; ++d)
+            for (Square s2 = SQ_A1; s2 <= SQ_D4; ++s2)
+                if (horse[d][s1] & square_bb(s2)) t[s1][s2] = square_bb(legs[d][s1]);
+    return t;
+}
+
+// Occupancy indexed horse tables: attacks from s for each leg index, or
+// attackers of s for each attacker index. Each index bit is set on a board
+// with only that neighbour occupied, so the tables agree with
+// horse_leg_index() and horse_attacker_index() by construction.
+constexpr Table<Bitboard, SQUARE_NB, 16> horse_occupancy_table(bool attackers) {
+    Table<Bitboard, SQUARE_NB, 16> t{};
+    const auto legBB = horse_leg_bbs();
+
+    for (Square s1 = SQ_A1; s1 <= SQ_D4; ++s1)
+        for (unsigned idx = 0; idx < 16; ++idx) {
+            Bitboard occupied = 0;
+            for (Square s2 = SQ_A1; s2 <= SQ_D4; ++s2) {
+                const unsigned bit = attackers ? horse_attacker_index(s1, square_bb(s2))
+                                               : horse_leg_index(s1, square_bb(s2));
+                if (bit & idx) occupied |= square_bb(s2);
+            }
+
+            for (Square s2 = SQ_A1; s2 <= SQ_D4; ++s2) {
+                const Bitboard leg = attackers ? legBB[s2][s1] : legBB[s1][s2];
+                if (leg && !(leg & occupied)) t[s1][idx] |= square_bb(s2);
+            }
+        }
+    return t;
+}
+
+}  // namespace Bitboards
+
+inline constexpr auto PopCnt16       = Bitboards::popcnt16();
+inline constexpr auto SquareDistance = Bitboards::square_distance();
+
+inline constexpr auto PseudoAttacks     = Bitboards::pseudo_attacks();
+inline constexpr auto HorseAttacks      = Bitboards::horse_attacks();
+inline constexpr auto HorseLegSquare    = Bitboards::horse_leg_squares();
+inline constexpr auto HorseLegBB        = Bitboards::horse_leg_bbs();
+inline constexpr auto HorseOccAttacks   = Bitboards::horse_occupancy_table(false);
+inline constexpr auto HorseOccAttackers = Bitboards::horse_occupancy_table(true);
+
+// Returns the leg square a horse on 'from' must find empty to reach 'to', or
+// an empty bitboard if 'to' is not a horse step away.
+inline Bitboard horse_leg_bb(Square from, Square to) {
+    assert(is_ok(from) && is_ok(to));
+    return HorseLegBB[from][to];
+}
+
+// Returns the squares from which a horse attacks s given the occupancy
+inline Bitboard horse_attackers_bb(Square s, Bitboard occupied) {
+    assert(is_ok(s));
+    return HorseOccAttackers[s][horse_attacker_index(s, occupied)];
 }
 
 // distance() functions return the distance between x and y, defined as the
@@ -122,7 +266,7 @@ inline int distance<Square>(Square x, Square y) {
 // Returns the pseudo attacks of the given piece type
 // assuming an empty board.
 template <PieceType Pt>
-inline Bitboard attacks_bb(Square s, Color c = COLOR_NB) {
+constexpr Bitboard attacks_bb(Square s, Color c = COLOR_NB) {
     assert((Pt != PAWN || c < COLOR_NB) && (is_ok(s)));
     return Pt == PAWN ? PseudoAttacks[c][s] : PseudoAttacks[Pt][s];
 }
@@ -131,21 +275,12 @@ inline Bitboard attacks_bb(Square s, Color c = COLOR_NB) {
 // assuming the board is occupied according to the passed Bitboard.
 // Sliding piece attacks do not continue passed an occupied square.
 template <PieceType Pt>
-inline Bitboard attacks_bb(Square s, Bitboard occupied) {
+constexpr Bitboard attacks_bb(Square s, Bitboard occupied) {
     assert((Pt != PAWN) && (is_ok(s)));
 
     switch (Pt) {
-        case HORSE: {
-            Bitboard attacks = 0;
-            // Check each direction only if the leg square is valid
-            for (int dir = DIR_N; dir < DIR_NB; ++dir) {
-                Square leg = HorseLegSquare[dir][s];
-                if (is_ok(leg) && !(occupied & square_bb(leg))) {
-                    attacks |= HorseAttacks[dir][s];
-                }
-            }
-            return attacks;
-        }
+        case HORSE:
+            return HorseOccAttacks[s][horse_leg_index(s, occupied)];
 
         default: {
             return PseudoAttacks[Pt][s];
@@ -156,7 +291,7 @@ inline Bitboard attacks_bb(Square s, Bitboard occupied) {
 // Returns the attacks by the given piece
 // assuming the board is occupied according to the passed Bitboard.
 // Sliding piece attacks do not continue passed an occupied square.
-inline Bitboard attacks_bb(PieceType pt, Square s, Bitboard occupied) {
+constexpr Bitboard attacks_bb(PieceType pt, Square s, Bitboard occupied) {
     assert((pt != PAWN) && (is_ok(s)));
 
     switch (pt) {
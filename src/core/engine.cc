@@ -0,0 +1,202 @@
+#include "engine.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string_view>
+
+#include "../minmax/thread.h"
+#include "../minmax/tt.h"
+#include "../solve/tb_bitbase.h"
+#include "movegen.h"
+#include "perft.h"
+
+namespace tiny {
+
+namespace {
+
+// Finds the legal move of pos written as str, or Move::none()
+Move to_move(const Position& pos, const std::string& str) {
+    for (Move m : MoveList<LEGAL>(pos))
+        if (to_string(m) == str) return m;
+    return Move::none();
+}
+
+// Checks the text of a FEN before Position::set, which trusts it: four ranks
+// of four squares, one king a side, no pawn on its last rank, pockets of the
+// right colour, and no more than the 8 pieces besides the kings with at most
+// 2 pawns, wherever they are.
+bool fen_text_is_ok(const std::string& fen) {
+    constexpr std::string_view PieceChars = "PHFWKphfwk";
+
+    std::istringstream ss(fen);
+    std::string        board, token;
+    int                count[PIECE_TYPE_NB] = {};
+    int                kings[COLOR_NB]      = {};
+
+    if (!(ss >> board)) return false;
+
+    int rank = 0, files = 0;
+    for (char c : board) {
+        size_t idx = PieceChars.find(c);
+        if (c == '/') {
+            if (files != 4 || ++rank > 3) return false;
+            files = 0;
+        } else if (c >= '1' && c <= '4')
+            files += c - '0';
+        else if (idx != std::string_view::npos) {
+            Color     col = idx < 5 ? WHITE : BLACK;
+            PieceType pt  = PieceType(PAWN + idx % 5);
+            if (pt == PAWN && rank == (col == WHITE ? 0 : 3)) return false;
+            if (pt == KING) ++kings[col];
+            else ++count[pt];
+            ++files;
+        } else
+            return false;
+        if (files > 4) return false;
+    }
+    if (rank != 3 || files != 4 || kings[WHITE] != 1 || kings[BLACK] != 1) return false;
+
+    // Optional pockets: [black] [white]
+    ss >> token;
+    if (!token.empty() && token.front() == '[') {
+        for (Color col : {BLACK, WHITE}) {
+            if (token.size() < 2 || token.front() != '[' || token.back() != ']') return false;
+            for (char c : token.substr(1, token.size() - 2)) {
+                size_t idx = PieceChars.find(c);
+                if (idx == std::string_view::npos || idx % 5 == 4 ||
+                    (idx < 5 ? WHITE : BLACK) != col)
+                    return false;
+                ++count[PAWN + idx % 5];
+            }
+            token.clear();
+            ss >> token;
+        }
+    }
+
+    if (token != "w" && token != "b") return false;
+
+    return count[PAWN] <= 2 && count[HORSE] + count[FERZ] + count[WAZIR] + count[PAWN] <= 8;
+}
+
+}  // namespace
+
+Engine::Engine() {
+    TT.resize(DEFAULT_HASH_MB);
+    states.emplace_back();
+    pos.set(StartFEN, &states.back());
+    gameFen = StartFEN;
+}
+
+Engine::~Engine() {
+    stop();
+    wait_for_search_finished();
+}
+
+void Engine::go(const Search::LimitsType& l) {
+    wait_for_search_finished();
+    limits = l;
+
+    // The flags are set here rather than on the search thread, so that a
+    // stop or ponderhit read right after go is not overwritten
+    Threads.reset_flags(limits.ponderMode);
+
+    searchThread = std::thread([this] {
+        TT.new_search();
+
+        if (limits.ponderMode && lastMove) {
+            Position before = pos;
+            before.undo_move(lastMove);
+            ponder_replies(before, lastMove, ponderReplies);
+            if (!Threads.ponder) limits.startTime = now();
+        }
+
+        SearchResult res = Threads.start_thinking(pos, limits, onIter);
+        if (onBestmove) onBestmove(res);
+    });
+}
+
+void Engine::stop() { Threads.request_stop(); }
+
+void Engine::ponderhit() { Threads.ponderhit(); }
+
+void Engine::wait_for_search_finished() {
+    if (searchThread.joinable()) searchThread.join();
+}
+
+std::string Engine::set_position(const std::string& fen, const std::vector<std::string>& moves) {
+    wait_for_search_finished();
+
+    const bool extends = fen == gameFen && moves.size() >= played.size() &&
+                         std::equal(played.begin(), played.end(), moves.begin());
+    if (!extends) {
+        // A position where the side to move could take the king is no game
+        // either. It is looked at on a copy, so that the game is kept when
+        // the FEN is rejected.
+        if (!fen_text_is_ok(fen)) return "bad FEN";
+
+        Position  check;
+        StateInfo checkSt;
+        check.set(fen, &checkSt);
+        Color us = check.side_to_move();
+        if (check.attackers_to(check.square<KING>(~us)) & check.pieces(us)) return "bad FEN";
+
+        states.clear();
+        states.emplace_back();
+        played.clear();
+        lastMove = Move::none();
+        pos.set(fen, &states.back());
+        gameFen = fen;
+    }
+
+    // The game stops at an illegal move, so that a corrected command can
+    // continue it
+    for (size_t i = played.size(); i < moves.size(); ++i) {
+        Move m = to_move(pos, moves[i]);
+        if (!m) return "illegal move " + moves[i];
+        states.emplace_back();
+        pos.do_move(m, states.back());
+        played.push_back(moves[i]);
+        lastMove = m;
+    }
+    return "";
+}
+
+void Engine::set_hash(size_t mb) {
+    wait_for_search_finished();
+    TT.resize(mb);
+}
+
+void Engine::set_threads(size_t n) {
+    wait_for_search_finished();
+    Threads.set(n);
+}
+
+void Engine::set_ponder_replies(int n) {
+    wait_for_search_finished();
+    ponderReplies = n;
+}
+
+int Engine::load_bitbase(const std::string& path) {
+    wait_for_search_finished();
+    if (path.empty()) {
+        tb::Bitbases.close();
+        return 0;
+    }
+    return tb::Bitbases.open(path);
+}
+
+// Forgets everything learned in the previous game
+void Engine::search_clear() {
+    wait_for_search_finished();
+    TT.clear();
+    gameFen.clear();
+    played.clear();
+    lastMove = Move::none();
+}
+
+uint64_t Engine::perft(int depth, size_t threads, size_t hashMB) {
+    wait_for_search_finished();
+    return Perft::run(pos, depth, threads, hashMB);
+}
+
+}  // namespace tiny
@@ -0,0 +1,87 @@
+#ifndef ENGINE_H_INCLUDED
+#define ENGINE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../minmax/minmax.h"
+#include "position.h"
+
+namespace tiny {
+
+// Engine is what a UCI session drives: the game being played, the options
+// and the search. The search runs on a thread of its own, so the caller can
+// go on reading commands, and answer isready, stop or ponderhit, while it
+// thinks. Everything else waits for a running search to finish first.
+class Engine {
+   public:
+    using OnIter     = std::function<void(const SearchResult&)>;
+    using OnBestmove = std::function<void(const SearchResult&)>;
+
+    static constexpr int DefaultPonderReplies = 2;
+
+    Engine();
+    ~Engine();
+
+    Engine(const Engine&)            = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Starts searching the current position and returns at once. The
+    // listeners are called on the search thread.
+    //
+    // go ponder is sent with the expected reply as the last move. Until
+    // ponderhit the answers to a few other likely replies are searched as
+    // well, see ponder_replies(), and our clock starts at ponderhit.
+    void go(const Search::LimitsType& limits);
+    void stop();
+    void ponderhit();
+    void wait_for_search_finished();
+
+    // Sets the game to fen followed by moves. If fen is the position the
+    // game started from and the moves continue the ones already played,
+    // only the new moves are made, so the StateInfo chain the repetition
+    // detection walks stays intact. Returns an error message, or an empty
+    // string.
+    std::string set_position(const std::string& fen, const std::vector<std::string>& moves);
+
+    void set_on_iter(OnIter f) { onIter = std::move(f); }
+    void set_on_bestmove(OnBestmove f) { onBestmove = std::move(f); }
+
+    // Options
+    void set_hash(size_t mb);
+    void set_threads(size_t n);
+    void set_ponder_replies(int n);
+    int  load_bitbase(const std::string& path);  // "" closes it
+    void search_clear();                         // ucinewgame
+
+    uint64_t        perft(int depth, size_t threads, size_t hashMB);
+    const Position& position() const { return pos; }
+
+   private:
+    // The game: the FEN it started from and the moves played since, each
+    // with its StateInfo. A deque does not move its elements as it grows,
+    // so the chain of previous pointers stays valid.
+    Position                 pos;
+    std::deque<StateInfo>    states;
+    std::string              gameFen;
+    std::vector<std::string> played;
+    Move                     lastMove = Move::none();  // the last of them
+
+    // Pondering also answers this many replies besides the expected one
+    int ponderReplies = DefaultPonderReplies;
+
+    // The workers refer to the limits for the whole search
+    Search::LimitsType limits;
+    std::thread        searchThread;
+    OnIter             onIter;
+    OnBestmove         onBestmove;
+};
+
+}  // namespace tiny
+
+#endif  // #ifndef ENGINE_H_INCLUDED
@@ -12,11 +12,89 @@
 #include <string>
 #include <vector>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define stringify2(x) #x
 #define stringify(x) stringify2(x)
 
 namespace tiny {
 
+using TimePoint = std::chrono::milliseconds::rep;  // A value in milliseconds
+static_assert(sizeof(TimePoint) == sizeof(int64_t), "TimePoint should be 64 bits");
+inline TimePoint now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Returns the upper 64 bits of the 128-bit product a * b, used to map a hash
+// key uniformly onto [0, b) without a modulo.
+inline uint64_t mul_hi64(uint64_t a, uint64_t b) {
+#if defined(__GNUC__) && defined(__SIZEOF_INT128__)
+    __extension__ using uint128 = unsigned __int128;
+    return (uint128(a) * uint128(b)) >> 64;
+#else
+    uint64_t aL = uint32_t(a), aH = a >> 32;
+    uint64_t bL = uint32_t(b), bH = b >> 32;
+    uint64_t c1 = (aL * bL) >> 32;
+    uint64_t c2 = aH * bL + c1;
+    uint64_t c3 = aL * bH + uint32_t(c2);
+    return aH * bH + (c2 >> 32) + (c3 >> 32);
+#endif
+}
+
+// Counts the non-zero bits of a 64-bit word. Bitboards are 16 bits, see
+// popcount() in bitboard.h; this is for the bit vectors of the tablebases.
+inline int popcount64(uint64_t b) {
+#if defined(__GNUC__)  // GCC, Clang, ICX
+
+    return __builtin_popcountll(b);
+
+#else  // Any other compiler, e.g. MSVC
+
+    b = b - ((b >> 1) & 0x5555555555555555ULL);
+    b = (b & 0x3333333333333333ULL) + ((b >> 2) & 0x3333333333333333ULL);
+    b = (b + (b >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return int((b * 0x0101010101010101ULL) >> 56);
+
+#endif
+}
+
+// Returns the index of the least significant bit of a non-zero 64-bit word,
+// as lsb() in bitboard.h does for bitboards
+inline int lsb64(uint64_t b) {
+    assert(b);
+
+#if defined(__GNUC__)  // GCC, Clang, ICX
+
+    return __builtin_ctzll(b);
+
+#elif defined(_MSC_VER)
+#ifdef _WIN64  // MSVC, WIN64
+
+    unsigned long idx;
+    _BitScanForward64(&idx, b);
+    return int(idx);
+
+#else  // MSVC, WIN32
+
+    unsigned long idx;
+
+    if (b & 0xffffffff) {
+        _BitScanForward(&idx, uint32_t(b));
+        return int(idx);
+    } else {
+        _BitScanForward(&idx, uint32_t(b >> 32));
+        return int(idx + 32);
+    }
+#endif
+#else  // Compiler is neither GCC nor MSVC compatible
+#error "Compiler not supported."
+#endif
+}
+
 // xorshift64star Pseudo-Random Number Generator
 // This class is based on original code written and dedicated
 // to the public domain by Sebastiano Vigna (2014).
@@ -35,23 +113,23 @@ namespace tiny {
 class PRNG {
     uint64_t s;
 
-    uint64_t rand64() {
+    constexpr uint64_t rand64() {
         s ^= s >> 12, s ^= s << 25, s ^= s >> 27;
         return s * 2685821657736338717LL;
     }
 
    public:
-    PRNG(uint64_t seed) : s(seed) { assert(seed); }
+    constexpr PRNG(uint64_t seed) : s(seed) { assert(seed); }
 
     template <typename T>
-    T rand() {
+    constexpr T rand() {
         return T(rand64());
     }
 
     // Special generator used to fast init magic numbers.
     // Output values only have 1/8th of their bits set on average.
     template <typename T>
-    T sparse_rand() {
+    constexpr T sparse_rand() {
         return T(rand64() & rand64() & rand64());
     }
 };
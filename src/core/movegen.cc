@@ -12,7 +12,7 @@ namespace tiny {
 namespace {
 
 template <Direction offset>
-inline Move* splat_pawn_moves(Move* moveList, Bitboard to_bb) {
+inline ExtMove* splat_pawn_moves(ExtMove* moveList, Bitboard to_bb) {
     while (to_bb) {
         Square to   = pop_lsb(to_bb);
         *moveList++ = Move(to - offset, to);
@@ -20,13 +20,13 @@ inline Move* splat_pawn_moves(Move* moveList, Bitboard to_bb) {
     return moveList;
 }
 
-inline Move* splat_moves(Move* moveList, Square from, Bitboard to_bb) {
+inline ExtMove* splat_moves(ExtMove* moveList, Square from, Bitboard to_bb) {
     while (to_bb) *moveList++ = Move(from, pop_lsb(to_bb));
     return moveList;
 }
 
 template <GenType Type, Direction D>
-Move* make_promotions(Move* moveList, [[maybe_unused]] Square to) {
+ExtMove* make_promotions(ExtMove* moveList, [[maybe_unused]] Square to) {
     *moveList++ = Move::make<PROMOTION>(to - D, to, HORSE);
     *moveList++ = Move::make<PROMOTION>(to - D, to, FERZ);
     *moveList++ = Move::make<PROMOTION>(to - D, to, WAZIR);
@@ -35,7 +35,7 @@ Move* make_promotions(Move* moveList, [[maybe_unused]] Square to) {
 }
 
 template <Color Us, GenType Type>
-Move* generate_pawn_moves(const Position& pos, Move* moveList, Bitboard target) {
+ExtMove* generate_pawn_moves(const Position& pos, ExtMove* moveList, Bitboard target) {
     constexpr Color    Them     = ~Us;
     constexpr Bitboard TRank3BB = (Us == WHITE ? Rank3BB : Rank2BB);
     // constexpr Bitboard  TRank3BB = (Us == WHITE ? Rank3BB : Rank6BB);
@@ -44,23 +44,25 @@ Move* generate_pawn_moves(const Position& pos, Move* moveList, Bitboard target)
     constexpr Direction UpLeft  = (Us == WHITE ? NORTH_WEST : SOUTH_EAST);
 
     const Bitboard emptySquares = ~pos.pieces();
-    const Bitboard enemies      = Type == EVASIONS ? pos.checkers() : pos.pieces(Them);
+    const Bitboard enemies      = Type == EVASIONS ? pos.checkers() & target : pos.pieces(Them);
 
     Bitboard pawnsOn3    = pos.pieces(Us, PAWN) & TRank3BB;
     Bitboard pawnsNotOn3 = pos.pieces(Us, PAWN) & ~TRank3BB;
 
     // Single pawn pushes, no promotions
-    Bitboard b1 = shift<Up>(pawnsNotOn3) & emptySquares;
+    if constexpr (Type != CAPTURES) {
+        Bitboard b1 = shift<Up>(pawnsNotOn3) & emptySquares;
 
-    if constexpr (Type == EVASIONS)  // Consider only blocking squares
-    {
-        b1 &= target;
-    }
+        if constexpr (Type == EVASIONS)  // Consider only blocking squares
+        {
+            b1 &= target;
+        }
 
-    moveList = splat_pawn_moves<Up>(moveList, b1);
+        moveList = splat_pawn_moves<Up>(moveList, b1);
+    }
 
     // Promotions
-    if (pawnsOn3) {
+    if (Type != QUIETS && pawnsOn3) {
         Bitboard b1 = shift<UpRight>(pawnsOn3) & enemies;
         Bitboard b2 = shift<UpLeft>(pawnsOn3) & enemies;
         Bitboard b3 = shift<Up>(pawnsOn3) & emptySquares;
@@ -75,7 +77,7 @@ Move* generate_pawn_moves(const Position& pos, Move* moveList, Bitboard target)
     }
 
     // Standard captures
-    if constexpr (Type == EVASIONS || Type == NON_EVASIONS) {
+    if constexpr (Type == CAPTURES || Type == EVASIONS || Type == NON_EVASIONS) {
         Bitboard b1 = shift<UpRight>(pawnsNotOn3) & enemies;
         Bitboard b2 = shift<UpLeft>(pawnsNotOn3) & enemies;
 
@@ -87,7 +89,7 @@ Move* generate_pawn_moves(const Position& pos, Move* moveList, Bitboard target)
 }
 
 template <Color Us, PieceType Pt>
-Move* generate_moves(const Position& pos, Move* moveList, Bitboard target) {
+ExtMove* generate_moves(const Position& pos, ExtMove* moveList, Bitboard target) {
     static_assert(Pt != KING && Pt != PAWN, "Unsupported piece type in generate_moves()");
 
     Bitboard bb = pos.pieces(Us, Pt);
@@ -103,60 +105,54 @@ Move* generate_moves(const Position& pos, Move* moveList, Bitboard target) {
 }
 
 template <Color Us, GenType Type>
-Move* generate_all(const Position& pos, Move* moveList) {
+ExtMove* generate_all(const Position& pos, ExtMove* moveList) {
     static_assert(Type != LEGAL, "Unsupported type in generate_all()");
 
     const Square ksq = pos.square<KING>(Us);
     Bitboard     target;
 
-    // Skip generating non-king moves when in double check
-    if (Type != EVASIONS || !more_than_one(pos.checkers())) {
-        if constexpr (Type == EVASIONS) {
-            // We are in EVASIONS and NOT double check here
-            Bitboard checkers = pos.checkers();
-            Square   checker  = lsb(checkers);
-
-            Bitboard checkerBB    = square_bb(checker);
-            bool     horseChecker = (pos.pieces(HORSE) & checkerBB) != 0;
-
-            if (horseChecker) {
-                // Block on the leg or capture the horse
-                // NOTE: horse_leg_bb expects (attacker, king)
-                target = horse_leg_bb(checker, ksq) | checkerBB;
-            } else {
-                target = checkerBB;
-            }
-        } else {
-            // NON_EVASIONS: any square not occupied by our pieces
-            target = ~pos.pieces(Us);
-        }
-
+    // EVASIONS:     capture the checker or block the leg of a checking horse
+    // NON_EVASIONS: any square not occupied by our pieces
+    // CAPTURES:     any square occupied by an enemy piece
+    // QUIETS/DROPS: any empty square
+    target = Type == EVASIONS     ? pos.evasion_targets()
+             : Type == NON_EVASIONS ? ~pos.pieces(Us)
+             : Type == CAPTURES     ? pos.pieces(~Us)
+                                    : ~pos.pieces();
+
+    // Skip generating non-king moves when no single move answers every check.
+    // This is usually a double check, but two horses may share a leg square.
+    if (Type != EVASIONS || target) {
         // Generate DROP moves from pocket
         // - Can drop on any empty square
         // - In EVASIONS, restrict to 'target' blocking set
         // - Pawns cannot be dropped on last rank (promotion rank)
-        const Bitboard emptySquares = ~pos.pieces();
-        Bitboard       dropMask     = (Type == EVASIONS ? (target & emptySquares) : emptySquares);
-
-        const Pocket pk = pos.pocket(Us);
-
-        auto gen_drops_for = [&](PieceType pt, Bitboard mask) {
-            if (pk.count(pt) == 0) return;
-            Bitboard to_bb = mask;
-            while (to_bb) {
-                Square to   = pop_lsb(to_bb);
-                *moveList++ = Move::make<DROP>(to, to, pt);
-            }
-        };
-
-        // Pawns: exclude last rank
-        Bitboard pawnMask = dropMask & (Us == WHITE ? ~Rank4BB : ~Rank1BB);
-        gen_drops_for(PAWN, pawnMask);
+        if constexpr (Type != CAPTURES && Type != QUIETS) {
+            const Bitboard emptySquares = ~pos.pieces();
+            Bitboard       dropMask     = (Type == EVASIONS ? (target & emptySquares) : emptySquares);
+
+            const Pocket pk = pos.pocket(Us);
+
+            auto gen_drops_for = [&](PieceType pt, Bitboard mask) {
+                if (pk.count(pt) == 0) return;
+                Bitboard to_bb = mask;
+                while (to_bb) {
+                    Square to   = pop_lsb(to_bb);
+                    *moveList++ = Move::make<DROP>(to, to, pt);
+                }
+            };
+
+            // Pawns: exclude last rank
+            Bitboard pawnMask = dropMask & (Us == WHITE ? ~Rank4BB : ~Rank1BB);
+            gen_drops_for(PAWN, pawnMask);
+
+            // Other pieces: HORSE, FERZ, WAZIR
+            gen_drops_for(HORSE, dropMask);
+            gen_drops_for(WAZIR, dropMask);
+            gen_drops_for(FERZ, dropMask);
+        }
 
-        // Other pieces: HORSE, FERZ, WAZIR
-        gen_drops_for(HORSE, dropMask);
-        gen_drops_for(WAZIR, dropMask);
-        gen_drops_for(FERZ, dropMask);
+        if constexpr (Type == DROPS) return moveList;
 
         moveList = generate_moves<Us, WAZIR>(pos, moveList, target);
         moveList = generate_moves<Us, FERZ>(pos, moveList, target);
@@ -164,6 +160,8 @@ Move* generate_all(const Position& pos, Move* moveList) {
         moveList = generate_pawn_moves<Us, Type>(pos, moveList, target);
     }
 
+    if constexpr (Type == DROPS) return moveList;
+
     Bitboard b = attacks_bb<KING>(ksq) & (Type == EVASIONS ? ~pos.pieces(Us) : target);
 
     moveList = splat_moves(moveList, ksq, b);
@@ -173,12 +171,15 @@ Move* generate_all(const Position& pos, Move* moveList) {
 
 }  // namespace
 
+// <CAPTURES>     Generates all pseudo-legal captures plus all promotions
+// <QUIETS>       Generates all pseudo-legal non-captures, except promotions and drops
+// <DROPS>        Generates all pseudo-legal drops
 // <EVASIONS>     Generates all pseudo-legal check evasions
 // <NON_EVASIONS> Generates all pseudo-legal captures and non-captures
 //
 // Returns a pointer to the end of the move list.
 template <GenType Type>
-Move* generate(const Position& pos, Move* moveList) {
+ExtMove* generate(const Position& pos, ExtMove* moveList) {
     static_assert(Type != LEGAL, "Unsupported type in generate()");
     assert((Type == EVASIONS) == bool(pos.checkers()));
 
@@ -189,17 +190,20 @@ Move* generate(const Position& pos, Move* moveList) {
 }
 
 // Explicit template instantiations
-template Move* generate<EVASIONS>(const Position&, Move*);
-template Move* generate<NON_EVASIONS>(const Position&, Move*);
+template ExtMove* generate<CAPTURES>(const Position&, ExtMove*);
+template ExtMove* generate<QUIETS>(const Position&, ExtMove*);
+template ExtMove* generate<DROPS>(const Position&, ExtMove*);
+template ExtMove* generate<EVASIONS>(const Position&, ExtMove*);
+template ExtMove* generate<NON_EVASIONS>(const Position&, ExtMove*);
 
 // generate<LEGAL> generates all the legal moves in the given position
 
 template <>
-Move* generate<LEGAL>(const Position& pos, Move* moveList) {
+ExtMove* generate<LEGAL>(const Position& pos, ExtMove* moveList) {
     Color    us     = pos.side_to_move();
     Bitboard pinned = pos.blockers_for_king(us) & pos.pieces(us);
     Square   ksq    = pos.square<KING>(us);
-    Move*    cur    = moveList;
+    ExtMove* cur    = moveList;
 
     moveList =
         pos.checkers() ? generate<EVASIONS>(pos, moveList) : generate<NON_EVASIONS>(pos, moveList);
@@ -10,7 +10,14 @@ namespace tiny {
 
 class Position;
 
-enum GenType { EVASIONS, NON_EVASIONS, LEGAL };
+enum GenType {
+    CAPTURES,  // Captures and all promotions
+    QUIETS,    // Non-capturing board moves, promotions excluded
+    DROPS,     // Drops from the pocket
+    EVASIONS,
+    NON_EVASIONS,
+    LEGAL
+};
 
 struct ExtMove : public Move {
     int value;
@@ -25,7 +32,7 @@ struct ExtMove : public Move {
 inline bool operator<(const ExtMove& f, const ExtMove& s) { return f.value < s.value; }
 
 template <GenType>
-Move* generate(const Position& pos, Move* moveList);
+ExtMove* generate(const Position& pos, ExtMove* moveList);
 
 // The MoveList struct wraps the generate() function and returns a convenient
 // list of moves. Using MoveList is sometimes preferable to directly calling
@@ -33,18 +40,20 @@ Move* generate(const Position& pos, Move* moveList);
 template <GenType T>
 struct MoveList {
     explicit MoveList(const Position& pos) : last(generate<T>(pos, moveList)) {}
-    const Move* begin() const { return moveList; }
-    const Move* end() const { return last; }
-    size_t      size() const { return last - moveList; }
-    bool        contains(Move move) const { return std::find(begin(), end(), move) != end(); }
-
-    const Move& operator[](size_t i) const {
+    const ExtMove* begin() const { return moveList; }
+    const ExtMove* end() const { return last; }
+    ExtMove*       begin() { return moveList; }
+    ExtMove*       end() { return last; }
+    size_t         size() const { return last - moveList; }
+    bool           contains(Move move) const { return std::find(begin(), end(), move) != end(); }
+
+    const ExtMove& operator[](size_t i) const {
         assert(i < size());
         return moveList[i];
     }
 
    private:
-    Move moveList[MAX_MOVES], *last;
+    ExtMove moveList[MAX_MOVES], *last;
 };
 
 }  // namespace tiny
@@ -0,0 +1,136 @@
+#include "perft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "misc.h"
+#include "movegen.h"
+#include "position.h"
+
+namespace tiny {
+
+namespace Perft {
+
+namespace {
+
+// Cache of subtree counts. The key does not know about promoted pawns, so
+// their bitboard is folded into the probe key to keep the counts exact.
+//
+// Slots are written without locks: each one stores the payload and the key
+// XOR-ed with the payload, so a slot torn by two concurrent writers simply
+// fails verification on probe and is treated as a miss.
+class Cache {
+   public:
+    explicit Cache(size_t mb) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Slot) <= mb * 1024 * 1024) count *= 2;
+
+        table = std::make_unique<Slot[]>(count);
+        mask  = count - 1;
+        for (size_t i = 0; i < count; ++i) table[i].check = table[i].data = 0;
+    }
+
+    bool probe(Key key, int depth, uint64_t& nodes) const {
+        const Slot& s    = table[key & mask];
+        uint64_t    data = s.data.load(std::memory_order_relaxed);
+        uint64_t    chk  = s.check.load(std::memory_order_relaxed);
+
+        if ((chk ^ data) != key || int(data & 0xFF) != depth) return false;
+
+        nodes = data >> 8;
+        return true;
+    }
+
+    void store(Key key, int depth, uint64_t nodes) {
+        Slot&    s    = table[key & mask];
+        uint64_t data = (nodes << 8) | uint64_t(depth);
+        s.data.store(data, std::memory_order_relaxed);
+        s.check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+   private:
+    struct Slot {
+        std::atomic<uint64_t> check, data;
+    };
+
+    std::unique_ptr<Slot[]> table;
+    size_t                  mask;
+};
+
+Key cache_key(const Position& pos) { return pos.key() ^ make_key(pos.promoted_pawns()); }
+
+uint64_t count(Position& pos, int depth, Cache* cache) {
+    if (depth <= 0) return 1;
+
+    if (depth == 1) return MoveList<LEGAL>(pos).size();
+
+    uint64_t nodes = 0;
+    Key      key   = cache ? cache_key(pos) : 0;
+
+    if (cache && cache->probe(key, depth, nodes)) return nodes;
+
+    StateInfo st;
+    for (const Move& m : MoveList<LEGAL>(pos)) {
+        pos.do_move(m, st);
+        nodes += count(pos, depth - 1, cache);
+        pos.undo_move(m);
+    }
+
+    if (cache) cache->store(key, depth, nodes);
+
+    return nodes;
+}
+
+}  // namespace
+
+uint64_t perft(Position& pos, int depth) { return count(pos, depth, nullptr); }
+
+uint64_t run(Position& pos, int depth, size_t threads, size_t hashMB, std::ostream& os) {
+    TimePoint start = now();
+
+    std::unique_ptr<Cache> cache = hashMB ? std::make_unique<Cache>(hashMB) : nullptr;
+
+    MoveList<LEGAL>       rootMoves(pos);
+    std::vector<uint64_t> counts(rootMoves.size());
+    std::atomic<size_t>   next{0};
+
+    // Each worker plays root moves on its own copy of the position. The copies
+    // share the (read-only) state chain behind the root.
+    auto worker = [&]() {
+        Position  p = pos;
+        StateInfo st;
+
+        for (size_t i; (i = next++) < rootMoves.size();) {
+            p.do_move(rootMoves[i], st);
+            counts[i] = count(p, depth - 1, cache.get());
+            p.undo_move(rootMoves[i]);
+        }
+    };
+
+    threads = std::clamp(threads, size_t(1), std::max(rootMoves.size(), size_t(1)));
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < threads; ++i) helpers.emplace_back(worker);
+    worker();
+    for (auto& th : helpers) th.join();
+
+    uint64_t nodes = depth <= 0 ? 1 : 0;
+    for (size_t i = 0; i < rootMoves.size() && depth > 0; ++i) {
+        os << to_string(rootMoves[i]) << ": " << counts[i] << "\n";
+        nodes += counts[i];
+    }
+
+    TimePoint elapsed = now() - start + 1;  // Ensure positivity to avoid a 'divide by zero'
+
+    os << "\nNodes searched: " << nodes << "\nTime (ms): " << elapsed
+       << "\nNodes/second: " << 1000 * nodes / elapsed << std::endl;
+
+    return nodes;
+}
+
+}  // namespace Perft
+
+}  // namespace tiny
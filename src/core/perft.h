@@ -0,0 +1,29 @@
+#ifndef PERFT_H_INCLUDED
+#define PERFT_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace tiny {
+
+class Position;
+
+namespace Perft {
+
+// Counts the leaf nodes of the legal move tree of the given depth. Depth 1 is
+// answered by the size of the move list, without making the moves.
+uint64_t perft(Position& pos, int depth);
+
+// Runs a full perft from pos and prints the per-root-move counts (divide),
+// the total, the elapsed time and nodes/second. Root moves are shared out to
+// 'threads' workers, and a non-zero 'hashMB' enables a Zobrist-keyed cache of
+// subtree counts that is shared by all workers.
+uint64_t run(Position& pos, int depth, size_t threads = 1, size_t hashMB = 0,
+             std::ostream& os = std::cout);
+
+}  // namespace Perft
+
+}  // namespace tiny
+
+#endif  // #ifndef PERFT_H_INCLUDED
@@ -16,18 +16,12 @@
 
 #include "bitboard.h"
 #include "misc.h"
+#include "unmovegen.h"
 
 using std::string;
 
 namespace tiny {
 
-namespace Zobrist {
-
-Key psq[PIECE_NB][SQUARE_NB];
-Key side;
-Key pocket[COLOR_NB][PIECE_TYPE_NB][3];  // [color][pieceType][count 0,1,2]
-}  // namespace Zobrist
-
 namespace {
 
 static constexpr Piece Pieces[] = {W_PAWN, W_HORSE, W_FERZ, W_WAZIR, W_KING,
@@ -39,6 +33,41 @@ static constexpr Piece Pieces[] = {W_PAWN, W_HORSE, W_FERZ, W_WAZIR, W_KING,
 constexpr std::string_view PieceToChar = " PHFWK   phfwk  ";
 }  // namespace
 
+// The hash keys are generated at compile time. They come from a fixed seed in
+// a fixed order, so every build has the same keys and tablebases written by
+// one build can be read by another.
+namespace Zobrist {
+
+struct Keys {
+    Key psq[PIECE_NB][SQUARE_NB]{};
+    Key side = 0;
+    Key pocket[COLOR_NB][PIECE_TYPE_NB][3]{};  // [color][pieceType][count 0,1,2]
+};
+
+constexpr Keys make_keys() {
+    Keys k;
+    PRNG rng(1070372);
+
+    for (Piece pc : Pieces)
+        for (Square s = SQ_A1; s <= SQ_D4; ++s) k.psq[pc][s] = rng.rand<Key>();
+    // pawns on these squares will promote
+    for (File f = FILE_A; f <= FILE_D; ++f)
+        k.psq[W_PAWN][make_square(f, RANK_4)] = k.psq[B_PAWN][make_square(f, RANK_1)] = 0;
+
+    k.side = rng.rand<Key>();
+
+    for (Color c = WHITE; c <= BLACK; ++c)
+        for (PieceType pt = PAWN; pt <= WAZIR; ++pt)
+            for (int count = 0; count < 3; ++count) k.pocket[c][pt][count] = rng.rand<Key>();
+    return k;
+}
+
+constexpr Keys        keys   = make_keys();
+constexpr const auto& psq    = keys.psq;
+constexpr Key         side   = keys.side;
+constexpr const auto& pocket = keys.pocket;
+}  // namespace Zobrist
+
 std::string square_string(Square s) {
     return std::string{char('a' + file_of(s)), char('1' + rank_of(s))};
 }
@@ -76,34 +105,17 @@ std::ostream& operator<<(std::ostream& os, const Position& pos) {
 // http://web.archive.org/web/20201107002606/https://marcelk.net/2013-04-06/paper/upcoming-rep-v2.pdf
 
 // First and second hash functions for indexing the cuckoo tables
-inline int H1(Key h) { return h & 0x7ff; }
-inline int H2(Key h) { return (h >> 16) & 0x7ff; }
+constexpr int H1(Key h) { return h & 0x7ff; }
+constexpr int H2(Key h) { return (h >> 16) & 0x7ff; }
 
 // Cuckoo tables with Zobrist hashes of valid reversible moves, and the moves themselves
-std::array<Key, 2048>  cuckoo;
-std::array<Move, 2048> cuckooMove;
-
-// Initializes at startup the various arrays used to compute hash keys
-void Position::init() {
-    PRNG rng(1070372);
+struct Cuckoo {
+    std::array<Key, 2048>  keys{};
+    std::array<Move, 2048> moves{};
+};
 
-    for (Piece pc : Pieces)
-        for (Square s = SQ_A1; s <= SQ_D4; ++s) Zobrist::psq[pc][s] = rng.rand<Key>();
-    // pawns on these squares will promote
-    std::fill_n(Zobrist::psq[W_PAWN] + SQ_A4, 4, 0);
-    std::fill_n(Zobrist::psq[B_PAWN] + SQ_A1, 4, 0);
-
-    Zobrist::side = rng.rand<Key>();
-
-    // Initialize pocket Zobrist keys
-    for (Color c = WHITE; c <= BLACK; ++c)
-        for (PieceType pt = PAWN; pt <= WAZIR; ++pt)
-            for (int count = 0; count < 3; ++count) Zobrist::pocket[c][pt][count] = rng.rand<Key>();
-
-    // Prepare the cuckoo tables
-    cuckoo.fill(0);
-    cuckooMove.fill(Move::none());
-    int count = 0;
+constexpr Cuckoo make_cuckoo() {
+    Cuckoo c;
     for (Piece pc : Pieces)
         for (Square s1 = SQ_A1; s1 <= SQ_D4; ++s1)
             for (Square s2 = Square(s1 + 1); s2 <= SQ_D4; ++s2)
@@ -112,15 +124,69 @@ void Position::init() {
                     Key  key  = Zobrist::psq[pc][s1] ^ Zobrist::psq[pc][s2] ^ Zobrist::side;
                     int  i    = H1(key);
                     while (true) {
-                        std::swap(cuckoo[i], key);
-                        std::swap(cuckooMove[i], move);
+                        const Key  k = c.keys[i];
+                        const Move m = c.moves[i];
+                        c.keys[i]    = key;
+                        c.moves[i]   = move;
+                        key          = k;
+                        move         = m;
                         if (move == Move::none())  // Arrived at empty slot?
                             break;
                         i = (i == H1(key)) ? H2(key) : H1(key);  // Push victim to alternative slot
                     }
-                    count++;
                 }
-    std::cout << count << " reversible moves in cuckoo hash\n";
+    return c;
+}
+
+constexpr Cuckoo cuckoo = make_cuckoo();
+
+// Copies the current state to si and makes it the only one: the position
+// forgets how it was reached, as if set from its FEN. Used to keep a copy of a
+// position after the StateInfo chain it points into goes out of scope.
+void Position::rebase(StateInfo* si) {
+    *si               = *st;
+    si->previous      = nullptr;
+    si->pliesFromNull = 0;
+    si->repetition    = 0;
+    st                = si;
+}
+
+// Packs the position into 16 bytes. The history (StateInfo chain) is lost.
+PackedPosition Position::pack() const {
+    PackedPosition pp{};
+
+    for (Square s = SQ_A1; s <= SQ_D4; ++s) pp.board |= uint64_t(board[s]) << (4 * s);
+
+    for (Color c : {WHITE, BLACK})
+        for (PieceType pt = PAWN; pt <= WAZIR; ++pt)
+            pp.pockets[c] |= uint8_t(pockets[c].count(pt) << (2 * (pt - PAWN)));
+
+    pp.promoted = promotedPawns;
+    pp.side     = uint8_t(sideToMove);
+
+    return pp;
+}
+
+// Initializes the position from its packed image, with si as its only state
+Position& Position::set(const PackedPosition& pp, StateInfo* si) {
+    *this = Position();
+    std::memset(si, 0, sizeof(StateInfo));
+    st = si;
+
+    for (Square s = SQ_A1; s <= SQ_D4; ++s)
+        if (Piece pc = Piece((pp.board >> (4 * s)) & 0xF)) put_piece(pc, s);
+
+    for (Color c : {WHITE, BLACK})
+        for (PieceType pt = PAWN; pt <= WAZIR; ++pt)
+            pockets[c].set_count(pt, (pp.pockets[c] >> (2 * (pt - PAWN))) & 0x3);
+
+    promotedPawns = pp.promoted;
+    sideToMove    = Color(pp.side);
+    set_state();
+
+    assert(pos_is_ok());
+
+    return *this;
 }
 
 // Initializes the position object with the given FEN string.
@@ -157,7 +223,7 @@ Position& Position::set(const string& fenStr, StateInfo* si) {
     Square             sq = SQ_A4;
     std::istringstream ss(fenStr);
 
-    std::memset(this, 0, sizeof(Position));
+    *this = Position();
     std::memset(si, 0, sizeof(StateInfo));
     st = si;
 
@@ -184,9 +250,9 @@ Position& Position::set(const string& fenStr, StateInfo* si) {
         // Parse black pocket
         ss.ignore();  // skip '['
         while (ss >> token && token != ']') {
-            if (token >= 'a' && token <= 'z') {
+            if (token >= 'a' && token <= 'z' && (idx = PieceToChar.find(token)) != string::npos) {
                 // Convert lowercase to piece type and add to black pocket
-                PieceType pt = PieceType(token - 'a' + PAWN);
+                PieceType pt = type_of(Piece(idx));
                 if (pt >= PAWN && pt <= WAZIR) pockets[BLACK].inc(pt);
             }
         }
@@ -196,9 +262,10 @@ Position& Position::set(const string& fenStr, StateInfo* si) {
         if (ss.peek() == '[') {
             ss.ignore();  // skip '['
             while (ss >> token && token != ']') {
-                if (token >= 'A' && token <= 'Z') {
+                if (token >= 'A' && token <= 'Z' &&
+                    (idx = PieceToChar.find(token)) != string::npos) {
                     // Convert uppercase to piece type and add to white pocket
-                    PieceType pt = PieceType(token - 'A' + PAWN);
+                    PieceType pt = type_of(Piece(idx));
                     if (pt >= PAWN && pt <= WAZIR) pockets[WHITE].inc(pt);
                 }
             }
@@ -206,6 +273,7 @@ Position& Position::set(const string& fenStr, StateInfo* si) {
     }
 
     // 2. Active color
+    while (ss.peek() == ' ') ss.ignore();
     ss >> token;
     sideToMove = (token == 'w' ? WHITE : BLACK);
     ss >> token;
@@ -265,21 +333,8 @@ void Position::set_check_info() const {
     st->checkSquares[PAWN] = attacks_bb<PAWN>(ksq, ~sideToMove);
 
     // For HORSE, squares that give check depend on the occupancy of the leg
-    // adjacent to the HORSE origin, not the king square. Build reverse-attacker
-    // set by filtering pseudo-origins with an empty leg square in current occupancy.
-    {
-        Bitboard result     = 0;
-        Bitboard candidates = attacks_bb<HORSE>(ksq);  // pseudo origins around king
-        Bitboard occ        = pieces();
-
-        while (candidates) {
-            Square   origin = pop_lsb(candidates);
-            Bitboard leg    = horse_leg_bb(origin, ksq);
-            if (!(occ & leg)) result |= square_bb(origin);
-        }
-
-        st->checkSquares[HORSE] = result;
-    }
+    // adjacent to the HORSE origin, which is a diagonal neighbour of the king.
+    st->checkSquares[HORSE] = horse_attackers_bb(ksq, pieces());
     st->checkSquares[FERZ]  = attacks_bb<FERZ>(ksq);
     st->checkSquares[WAZIR] = attacks_bb<WAZIR>(ksq);
     st->checkSquares[KING]  = 0;
@@ -308,21 +363,68 @@ void Position::set_state() const {
     if (sideToMove == BLACK) st->key ^= Zobrist::side;
 }
 
+// Returns a key shared by the symmetric images of the position, derived from
+// the smallest of their keys with the promoted pawns mixed in, and sets sym to
+// the symmetry that maps the position to that image. Symmetric positions thus
+// share one hash entry; moves stored with it are in the frame of the image and
+// go back with transform(m, sym).
+Key Position::canonical_key(Symmetry& sym) const {
+    Key      keys[SYMMETRY_NB]     = {st->key};
+    Bitboard promoted[SYMMETRY_NB] = {promotedPawns};
+
+    for (Bitboard b = pieces(); b;) {
+        Square s  = pop_lsb(b);
+        Piece  pc = piece_on(s);
+
+        keys[MIRROR] ^= Zobrist::psq[pc][tiny::transform(s, MIRROR)];
+        keys[FLIP] ^= Zobrist::psq[~pc][tiny::transform(s, FLIP)];
+        keys[MIRROR_FLIP] ^= Zobrist::psq[~pc][tiny::transform(s, MIRROR_FLIP)];
+    }
+
+    for (Bitboard b = promotedPawns; b;) {
+        Square s = pop_lsb(b);
+        for (int i = MIRROR; i < SYMMETRY_NB; ++i) promoted[i] |= tiny::transform(s, Symmetry(i));
+    }
+
+    // Mirroring keeps the pockets, flipping swaps them
+    Key pocketKeys = 0, flippedPocketKeys = 0;
+    for (Color c = WHITE; c <= BLACK; ++c)
+        for (PieceType pt = PAWN; pt <= WAZIR; ++pt) {
+            pocketKeys ^= Zobrist::pocket[c][pt][pockets[c].count(pt)];
+            flippedPocketKeys ^= Zobrist::pocket[~c][pt][pockets[c].count(pt)];
+        }
+
+    const Key side = sideToMove == BLACK ? Zobrist::side : 0;
+    keys[MIRROR] ^= pocketKeys ^ side;
+    keys[FLIP] ^= flippedPocketKeys ^ side ^ Zobrist::side;
+    keys[MIRROR_FLIP] ^= flippedPocketKeys ^ side ^ Zobrist::side;
+
+    Key best = 0;
+    for (int i = IDENTITY; i < SYMMETRY_NB; ++i) {
+        Key k = keys[i] ^ make_key(promoted[i]);
+        if (i == IDENTITY || k < best) {
+            best = k;
+            sym  = Symmetry(i);
+        }
+    }
+
+    // The minimum of four keys is biased towards small values, which would
+    // crowd the first TT clusters. A bijective mix makes it uniform again.
+    best ^= best >> 33;
+    best *= 0xFF51AFD7ED558CCDULL;
+    best ^= best >> 33;
+    best *= 0xC4CEB9FE1A85EC53ULL;
+    best ^= best >> 33;
+
+    return best;
+}
+
 // Computes a bitboard of all pieces which attack a given square.
 // Slider attacks use the occupied bitboard to indicate occupancy.
 Bitboard Position::attackers_to(Square s, Bitboard occupied) const {
     // HORSE needs special reverse handling: whether a HORSE on origin attacks s
     // depends on the occupancy of its leg adjacent to the origin square.
-    Bitboard horseAttackers = 0;
-    {
-        Bitboard candidates = attacks_bb<HORSE>(s);  // pseudo origins around s
-        candidates &= pieces(HORSE);
-
-        while (candidates) {
-            Square origin = pop_lsb(candidates);
-            if (!(occupied & horse_leg_bb(origin, s))) horseAttackers |= square_bb(origin);
-        }
-    }
+    Bitboard horseAttackers = horse_attackers_bb(s, occupied) & pieces(HORSE);
 
     return (attacks_bb<FERZ>(s) & pieces(FERZ)) | (attacks_bb<WAZIR>(s) & pieces(WAZIR)) |
            (attacks_bb<PAWN>(s, BLACK) & pieces(WHITE, PAWN)) |
@@ -337,14 +439,8 @@ bool Position::attackers_to_exist(Square s, Bitboard occupied, Color c) const {
     }
 
     // Horse (xiangqi): reverse-origin with leg-block check against occupied
-    {
-        Bitboard candidates = attacks_bb<HORSE>(s) & pieces(c, HORSE);
-        while (candidates) {
-            Square origin = pop_lsb(candidates);
-            if (!(occupied & horse_leg_bb(origin, s))) {
-                return true;
-            }
-        }
+    if (horse_attackers_bb(s, occupied) & pieces(c, HORSE)) {
+        return true;
     }
 
     // Ferz: diagonal king-step (no occupancy needed)
@@ -409,32 +505,131 @@ bool Position::legal(Move m) const {
     return !more_than_one(legPinners);
 }
 
+// Takes a random move and tests whether the move is
+// pseudo-legal. It is used to validate moves from TT that can be corrupted
+// due to SMP concurrent access or hash position key aliasing.
+bool Position::pseudo_legal(const Move m) const {
+    Color us = sideToMove;
+
+    if (!m.is_ok() || m.type_of() > DROP) return false;
+
+    Square from = m.from_sq();
+    Square to   = m.to_sq();
+
+    if (!is_ok(from) || !is_ok(to)) return false;
+
+    if (m.type_of() == DROP) {
+        PieceType pt = m.drop_piece();
+
+        // The piece must be in our pocket and land on an empty square, pawns
+        // never on the last rank
+        if (from != to || !pockets[us].count(pt) || !empty(to) ||
+            (pt == PAWN && relative_rank(us, to) == RANK_4))
+            return false;
+
+        // A drop can only answer a check by blocking a horse leg
+        return !checkers() || (evasion_targets() & to);
+    }
+
+    Piece pc = piece_on(from);
+
+    // If the 'from' square is not occupied by a piece belonging to the side to
+    // move, the move is obviously not legal.
+    if (pc == NO_PIECE || color_of(pc) != us) return false;
+
+    // The destination square cannot be occupied by a friendly piece
+    if (pieces(us) & to) return false;
+
+    if (type_of(pc) == PAWN) {
+        // Pawns reaching the last rank must promote, and only pawns promote
+        if ((relative_rank(us, to) == RANK_4) != (m.type_of() == PROMOTION)) return false;
+
+        if (m.type_of() == PROMOTION && m.promotion_type() > WAZIR) return false;
+
+        if (!(attacks_bb<PAWN>(from, us) & pieces(~us) & square_bb(to))  // Not a capture
+            && !((from + pawn_push(us) == to) && empty(to)))  // Not a single push
+            return false;
+    } else if (m.type_of() == PROMOTION || !(attacks_bb(type_of(pc), from, pieces()) & to))
+        return false;
+
+    // Evasions generator already takes care to avoid some kind of illegal moves
+    // and legal() relies on this. We therefore have to take care that the same
+    // kind of moves are filtered out here.
+    if (checkers()) {
+        if (type_of(pc) != KING) {
+            // Our move must be a capture of the checking piece or a block of
+            // the leg of a checking horse. In double check this is usually
+            // impossible and a king move is required.
+            if (!(evasion_targets() & to)) return false;
+        }
+        // In case of king moves under check we have to remove the king so as to
+        // catch invalid moves like b1a1 when opposite horse is on c2.
+        else if (attackers_to_exist(to, pieces() ^ from, ~us))
+            return false;
+    }
+
+    return true;
+}
+
 // Calculates st->blockersForKing[c],
 // which store respectively the pieces preventing king of color c from being in check
 void Position::update_slider_blockers(Color c) const {
     Square ksq = square<KING>(c);
 
     st->blockersForKing[c] = 0;
+    st->pinners[c]         = 0;
 
-    // Enemy horses that geometrically attack ksq (reverse pseudo)
-    Bitboard snipers = (attacks_bb<HORSE>(ksq) & pieces(HORSE)) & pieces(~c);
+    // Enemy horses that geometrically attack ksq but have their leg blocked.
+    // A leg is a diagonal neighbour of the king, so a horse never blocks
+    // another horse here.
+    Bitboard snipers = attacks_bb<HORSE>(ksq) & ~horse_attackers_bb(ksq, pieces()) &
+                       pieces(~c, HORSE);
 
-    // Ignore snipers themselves in occupancy
-    Bitboard occupancy = pieces() ^ snipers;
+    st->pinners[c] = snipers;
 
-    while (snipers) {
-        Square sniperSq = pop_lsb(snipers);
+    while (snipers) st->blockersForKing[c] |= horse_leg_bb(pop_lsb(snipers), ksq);
+}
 
-        // Leg square required for this horse to attack the king
-        Bitboard leg = horse_leg_bb(sniperSq, ksq);
+// Takes back the move described by um, which must come from generate_unmoves():
+// the position becomes the predecessor, with the side that made the move to
+// play and si as its only state.
+void Position::retract(const UnMove& um, StateInfo* si) {
+    const Color  them = ~sideToMove;
+    const Move   m    = um.move;
+    const Square to   = m.to_sq();
 
-        // If that leg square is occupied by piece, it's a blocker
-        Bitboard b = leg & occupancy;
-        if (b) {
-            st->blockersForKing[c] |= b;
-            st->pinners[c] |= sniperSq;
+    if (m.type_of() == DROP) {
+        remove_piece(to);
+        pocket_add_captured(m.drop_piece(), them);
+    } else {
+        const Square from     = m.from_sq();
+        const bool   promoted = is_promoted_pawn(to);
+        const Piece  pc = m.type_of() == PROMOTION ? make_piece(them, PAWN) : piece_on(to);
+
+        remove_piece(to);
+        if (promoted) clear_promoted(to);
+
+        // A promoted piece keeps its tag, unless this move promoted it
+        put_piece(pc, from);
+        if (promoted && m.type_of() != PROMOTION) track_promoted_pawn(from);
+
+        // The captured piece comes back from the mover's pocket, demoted if it
+        // was a promoted pawn
+        if (um.captured) {
+            put_piece(um.captured, to);
+            if (um.capturedPromoted) track_promoted_pawn(to);
+            pocket_remove(um.capturedPromoted ? PAWN : type_of(um.captured), them);
         }
     }
+
+    sideToMove = them;
+    gamePly    = std::max(gamePly - 1, 0);
+
+    std::memset(si, 0, sizeof(StateInfo));
+    st = si;
+    set_state();
+
+    assert(pos_is_ok());
 }
 
 // Tests whether a pseudo-legal move gives a check
@@ -488,9 +683,10 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
     newSt.previous = st;
     st             = &newSt;
 
-    // Increment ply counters. In particular, rule50 will be reset to zero later on
-    // in case of a capture or a pawn move.
+    // Increment ply counters. pliesFromNull bounds the repetition scan below to
+    // the states actually linked behind us.
     ++gamePly;
+    ++st->pliesFromNull;
 
     Color  us       = sideToMove;
     Color  them     = ~us;
@@ -507,13 +703,15 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
         // Add piece to pocket
         // Check if captured piece is a promoted pawn
         st->capturedWasPromotedPawn = is_promoted_pawn(to);
-        if (st->capturedWasPromotedPawn) {
-            pocket_add_captured(PAWN, us);
-            clear_promoted(to);
+        PieceType pt                = st->capturedWasPromotedPawn ? PAWN : type_of(captured);
+        int       cnt               = pockets[us].count(pt);
 
-        } else {
-            pocket_add_captured(type_of(captured), us);
-        }
+        if (st->capturedWasPromotedPawn) clear_promoted(to);
+
+        // Toggle out previous count, then toggle in new count+1
+        k ^= Zobrist::pocket[us][pt][cnt];
+        pocket_add_captured(pt, us);
+        k ^= Zobrist::pocket[us][pt][cnt + 1];
 
         // Update board and piece lists
         remove_piece(to);
@@ -529,6 +727,7 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
         move_piece(from, to);
     } else {
         put_piece(pc, to);
+        k ^= Zobrist::psq[pc][to];
         // Update pocket and hash for drop: decrement pocket count
         PieceType dpt = m.drop_piece();
         PieceType pt  = dpt;
@@ -589,7 +788,7 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
     st->repetition = 0;
 
     StateInfo* stp = st->previous->previous;
-    for (int i = 4; i <= gamePly; i += 2) {
+    for (int i = 4; i <= st->pliesFromNull; i += 2) {
         stp = stp->previous->previous;
         if (stp->key == st->key) {
             st->repetition = stp->repetition ? -i : i;
@@ -683,6 +882,34 @@ bool Position::is_threefold_game() const {
     return false;
 }
 
+// Applies a symmetry of the rules to the position. Useful for debugging
+// evaluation and search symmetry. The history is lost: the current state
+// becomes the only one.
+void Position::transform(Symmetry sym) {
+    const bool     swap = sym & FLIP;
+    PackedPosition pp   = pack(), t{};
+
+    for (Square s = SQ_A1; s <= SQ_D4; ++s)
+        if (Piece pc = Piece((pp.board >> (4 * s)) & 0xF))
+            t.board |= uint64_t(swap ? ~pc : pc) << (4 * tiny::transform(s, sym));
+
+    for (Bitboard b = pp.promoted; b;) t.promoted |= tiny::transform(pop_lsb(b), sym);
+
+    t.pockets[WHITE] = pp.pockets[swap ? BLACK : WHITE];
+    t.pockets[BLACK] = pp.pockets[swap ? WHITE : BLACK];
+    t.side           = uint8_t(pp.side ^ swap);
+
+    const int ply = gamePly;
+    set(t, st);
+    gamePly = ply;
+}
+
+// Swaps the colours: ranks are reversed and the side to move changes
+void Position::flip() { transform(FLIP); }
+
+// Swaps the a- and d-files
+void Position::mirror() { transform(MIRROR); }
+
 // Performs some consistency checks for the position object
 // and raise an assert if something wrong is detected.
 // This is meant to be helpful when debugging.
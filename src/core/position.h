@@ -39,6 +39,7 @@ namespace tiny {
 
 struct StateInfo {
     // Copied when making a move
+    int pliesFromNull;
 
     // Not copied when making a move (will be recomputed anyhow)
     Key        key;
@@ -58,14 +59,34 @@ struct StateInfo {
 // elements are not invalidated upon list resizing.
 using StateListPtr = std::unique_ptr<std::deque<StateInfo>>;
 
+constexpr auto StartFEN = "fhwk/3p/P3/KWHF w 1";
+
+struct UnMove;
+
+// PackedPosition is a 16 byte image of a position without its history, used
+// to keep positions in bulk (e.g. one per node of the retrograde solver).
+struct PackedPosition {
+    uint64_t board;              // 4 bits per square: the Piece on it
+    uint16_t promoted;           // Promoted pawns
+    uint8_t  pockets[COLOR_NB];  // 2 bits per piece type, PAWN..WAZIR
+    uint8_t  side;
+
+    bool operator==(const PackedPosition& pp) const {
+        return board == pp.board && promoted == pp.promoted && pockets[WHITE] == pp.pockets[WHITE] &&
+               pockets[BLACK] == pp.pockets[BLACK] && side == pp.side;
+    }
+};
+
 class Position {
    public:
-    // init
-    static void init();  // fills attack tables & Zobrist
-
     // FEN string input/output
     Position&   set(const std::string& fenStr, StateInfo* si);
     std::string fen() const;
+    void        rebase(StateInfo* si);
+
+    // Compact storage
+    PackedPosition pack() const;
+    Position&      set(const PackedPosition& pp, StateInfo* si);
 
     // Position representation
     Bitboard pieces() const;  // All pieces
@@ -76,6 +97,7 @@ class Position {
     Bitboard pieces(Color c, PieceTypes... pts) const;
 
     const Pocket& pocket(Color c) const;
+    Bitboard      promoted_pawns() const;
 
     inline Piece piece_on(Square s) const {
         assert(is_ok(s));
@@ -94,6 +116,7 @@ class Position {
     Bitboard blockers_for_king(Color c) const;
     Bitboard check_squares(PieceType pt) const;
     Bitboard pinners(Color c) const;
+    Bitboard evasion_targets() const;
 
     // Attacks to/from a given square
     Bitboard attackers_to(Square s) const;
@@ -104,7 +127,9 @@ class Position {
 
     // Properties of moves
     bool  legal(Move m) const;
+    bool  pseudo_legal(const Move m) const;
     bool  gives_check(Move m) const;
+    bool  capture(Move m) const;
     Piece moved_piece(Move m) const;
 
     // Doing and undoing moves
@@ -112,8 +137,12 @@ class Position {
     void do_move(Move m, StateInfo& newSt, bool givesCheck);
     void undo_move(Move m);
 
+    // Retrograde analysis
+    void retract(const UnMove& um, StateInfo* si);
+
     // Accessing hash keys
     Key key() const;
+    Key canonical_key(Symmetry& sym) const;
 
     // Other properties of the position
     inline Color side_to_move() const { return sideToMove; }
@@ -127,6 +156,8 @@ class Position {
     // Position consistency check, for debugging
     bool pos_is_ok() const;
     void flip();
+    void mirror();
+    void transform(Symmetry sym);
 
     void put_piece(Piece pc, Square s);
     void remove_piece(Square s);
@@ -176,6 +207,8 @@ inline Piece Position::moved_piece(Move m) const {
 
 inline const Pocket& Position::pocket(Color c) const { return pockets[c]; }
 
+inline Bitboard Position::promoted_pawns() const { return promotedPawns; }
+
 inline Bitboard Position::pieces() const { return byTypeBB[ALL_PIECES]; }
 
 template <typename... PieceTypes>
@@ -216,6 +249,20 @@ inline Bitboard Position::check_squares(PieceType pt) const { return st->checkSq
 
 inline Bitboard Position::pinners(Color c) const { return st->pinners[c]; }
 
+// Returns the squares where a drop or a non-king move answers every check:
+// the checker itself, or the leg of a checking horse.
+inline Bitboard Position::evasion_targets() const {
+    const Square ksq    = square<KING>(sideToMove);
+    Bitboard     target = ~Bitboard(0);
+
+    for (Bitboard b = checkers(); b;) {
+        Square checksq = pop_lsb(b);
+        target &= type_of(piece_on(checksq)) == HORSE ? checksq | horse_leg_bb(checksq, ksq)
+                                                      : square_bb(checksq);
+    }
+    return target;
+}
+
 inline void Position::put_piece(Piece pc, Square s) {
     board[s] = pc;
     byTypeBB[ALL_PIECES] |= byTypeBB[type_of(pc)] |= s;
@@ -247,6 +294,11 @@ inline void Position::move_piece(Square from, Square to) {
     board[to]   = pc;
 }
 
+inline bool Position::capture(Move m) const {
+    assert(m.is_ok());
+    return m.type_of() != DROP && !empty(m.to_sq());
+}
+
 inline void Position::do_move(Move m, StateInfo& newSt) { do_move(m, newSt, gives_check(m)); }
 
 }  // namespace tiny
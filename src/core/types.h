@@ -98,11 +98,38 @@ inline constexpr Value piece_value(Piece p) {
 constexpr Value START_MATERIAL = PawnValue + HorseValue + FerzValue + WazirValue;
 constexpr Value EVAL_MAX       = (HorseValue + FerzValue + WazirValue + WazirValue) * 2;
 
-constexpr Value VALUE_MATE     = 2200;
+constexpr Value VALUE_MATE     = 4800;
 constexpr Value VALUE_ZERO     = 0;
 constexpr Value VALUE_DRAW     = 0;
-constexpr Value VALUE_NONE     = 2202;
-constexpr Value VALUE_INFINITE = 2201;
+constexpr Value VALUE_NONE     = 4802;
+constexpr Value VALUE_INFINITE = 4801;
+
+constexpr Value VALUE_MATE_IN_MAX_PLY  = VALUE_MATE - MAX_PLY;
+constexpr Value VALUE_MATED_IN_MAX_PLY = -VALUE_MATE_IN_MAX_PLY;
+
+// Mate scores are shifted by ply in the TT, so no evaluation may reach them
+static_assert(VALUE_MATE_IN_MAX_PLY > EVAL_MAX, "Mate band overlaps the evaluation");
+
+// A win known from the bitbase, which has no distances: above any
+// evaluation, below any mate the search can see
+constexpr Value VALUE_TB_WIN  = VALUE_MATE_IN_MAX_PLY - 1;
+constexpr Value VALUE_TB_LOSS = -VALUE_TB_WIN;
+
+// Positions the bitbase says are still won, which the search plays on
+// towards the mate, are scored around this by their evaluation, so that
+// they stay above every draw and below VALUE_TB_WIN
+constexpr Value VALUE_TB_WIN_LINE = VALUE_TB_WIN / 2;
+
+static_assert(VALUE_TB_WIN > EVAL_MAX, "Bitbase wins overlap the evaluation");
+static_assert(VALUE_TB_WIN_LINE - EVAL_MAX > VALUE_DRAW && VALUE_TB_WIN_LINE + EVAL_MAX < VALUE_TB_WIN,
+              "Won lines overlap the draws or the bitbase wins");
+
+enum Bound : uint8_t {
+    BOUND_NONE,
+    BOUND_UPPER,
+    BOUND_LOWER,
+    BOUND_EXACT = BOUND_UPPER | BOUND_LOWER
+};
 
 enum Square : int8_t {
     SQ_A1,
@@ -174,6 +201,21 @@ constexpr bool is_ok(Square s) { return s >= SQ_A1 && s <= SQ_D4; }
 
 constexpr Piece operator~(Piece pc) { return Piece(pc ^ 8); }
 
+// Symmetries of the rules. MIRROR swaps the files a <-> d, FLIP reverses the
+// ranks and swaps the colours, side to move included. Each of them is its own
+// inverse, and none changes the value of a position.
+enum Symmetry : int {
+    IDENTITY,
+    MIRROR,
+    FLIP,
+    MIRROR_FLIP,
+    SYMMETRY_NB
+};
+
+constexpr Square transform(Square s, Symmetry sym) {
+    return Square(s ^ (sym & MIRROR ? SQ_D1 : 0) ^ (sym & FLIP ? SQ_A4 : 0));
+}
+
 constexpr Piece make_piece(Color c, PieceType pt) { return Piece((c << 3) + pt); }
 
 constexpr PieceType type_of(Piece pc) { return PieceType(pc & 7); }
@@ -338,6 +380,13 @@ class Move {
     std::uint16_t data;
 };
 
+// Maps a move to the same move in the transformed position
+constexpr Move transform(Move m, Symmetry sym) {
+    if (!m.is_ok()) return m;
+    return Move(std::uint16_t((m.raw() & 0xF000) + (transform(m.from_sq(), sym) << 6) +
+                              transform(m.to_sq(), sym)));
+}
+
 inline std::string to_string(Move m);
 inline const char* pt_code(PieceType pt);
 inline void        square_to_cstr(Square s, char out[3]);
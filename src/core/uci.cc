@@ -0,0 +1,309 @@
+#include "uci.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "../minmax/thread.h"
+#include "../minmax/tt.h"
+#include "../solve/tb_bitbase.h"
+#include "movegen.h"
+#include "position.h"
+
+namespace tiny {
+
+namespace {
+
+// Positions searched by bench: the start and a few from played games
+const std::vector<std::string> BenchFens = {
+    StartFEN,
+    "f1wk/f3/P1p1/K1H1 [w] [H] w  4",
+    "W2F/1whk/2Hp/KW1F w  7",
+    "W2k/K1h1/2Hp/3F [f] [WW] w  10",
+    "f1wk/4/P1Fp/KH2 [hw] [] w  7",
+    "fH2/Pfk1/3p/K1w1 [h] [W] w  13",
+};
+
+constexpr int BenchDepth = 11;
+
+// Output comes from the search thread as well as from the input loop
+std::mutex ioMutex;
+
+}  // namespace
+
+UCIEngine::UCIEngine(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) commandLine += std::string(argv[i]) + " ";
+
+    init_search_update_listeners();
+}
+
+void UCIEngine::init_search_update_listeners() {
+    engine.set_on_iter(on_iter);
+    engine.set_on_bestmove(on_bestmove);
+}
+
+// Reads commands until quit. Arguments on the command line are run as one
+// command instead, e.g. "engine_main bench".
+void UCIEngine::loop() {
+    std::string cmd, token;
+    bool        fromArgs = !commandLine.empty();
+
+    while (fromArgs || std::getline(std::cin, cmd)) {
+        if (fromArgs) cmd = commandLine;
+
+        std::istringstream is(cmd);
+        token.clear();
+        is >> std::skipws >> token;
+
+        if (token == "quit" || token == "exit" || token == "stop")
+            engine.stop();
+
+        // The opponent played the move we pondered on: the search goes on,
+        // now on our clock
+        else if (token == "ponderhit")
+            engine.ponderhit();
+
+        else if (token == "uci") {
+            print("id name tinyhouse\n"
+                  "option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) +
+                  " min 1 max 65536\n"
+                  "option name Threads type spin default 1 min 1 max 256\n"
+                  "option name Ponder type check default false\n"
+                  "option name PonderReplies type spin default " +
+                  std::to_string(Engine::DefaultPonderReplies) + " min 0 max 16\n"
+                  "option name Bitbase type string default <empty>\n"
+                  "uciok\n");
+        }
+
+        else if (token == "isready")
+            print("readyok\n");
+        else if (token == "setoption")
+            setoption(is);
+        else if (token == "ucinewgame")
+            engine.search_clear();
+        else if (token == "position")
+            position(is);
+        else if (token == "go")
+            go(is);
+        else if (token == "bench")
+            bench(is);
+        else if (token == "perft")
+            perft(is);
+
+        // Optional helper for debugging from a terminal
+        else if (token == "d") {
+            engine.wait_for_search_finished();
+            std::ostringstream os;
+            os << engine.position();
+            print(os.str());
+        }
+
+        else if (!token.empty())
+            print_info_string("unknown command");
+
+        if (fromArgs || token == "quit" || token == "exit") break;
+    }
+
+    // At the end of the input a bounded search is let finish, so that piped
+    // commands get their answer. Only quit stops it.
+    if (token != "quit" && token != "exit" && !unbounded) engine.wait_for_search_finished();
+}
+
+void UCIEngine::print(const std::string& str) {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    std::cout << str << std::flush;
+}
+
+void UCIEngine::print_info_string(std::string_view str) {
+    print("info string " + std::string(str) + "\n");
+}
+
+// go [depth N] [movetime MS] [nodes N] [wtime MS] [btime MS] [winc MS] [binc MS]
+//    [infinite] [ponder]
+//
+// Throws std::invalid_argument or std::out_of_range on a bad number.
+Search::LimitsType UCIEngine::parse_limits(std::istream& is) {
+    Search::LimitsType limits;
+    std::string        token;
+
+    auto number = [&] {
+        std::string v;
+        is >> v;
+        return std::stoll(v);
+    };
+
+    while (is >> token)
+        if (token == "infinite") limits.infinite = true;
+        else if (token == "ponder") limits.ponderMode = true;
+        else if (token == "depth") limits.depth = int(number());
+        else if (token == "movetime") limits.movetime = number();
+        else if (token == "nodes") limits.nodes = uint64_t(number());
+        else if (token == "wtime") limits.time[WHITE] = number();
+        else if (token == "btime") limits.time[BLACK] = number();
+        else if (token == "winc") limits.inc[WHITE] = number();
+        else if (token == "binc") limits.inc[BLACK] = number();
+
+    // Plain "go" keeps the historical fixed depth
+    if (!limits.depth && !limits.movetime && !limits.nodes && !limits.infinite &&
+        !limits.use_time_management())
+        limits.depth = 9;
+
+    return limits;
+}
+
+void UCIEngine::go(std::istringstream& is) {
+    Search::LimitsType limits;
+    try {
+        limits = parse_limits(is);
+    } catch (...) {
+        print_info_string("error: bad go parameters");
+        return;
+    }
+
+    engine.wait_for_search_finished();
+    if (MoveList<LEGAL>(engine.position()).size() == 0) {
+        print("bestmove none score 0\n");
+        return;
+    }
+
+    unbounded = limits.infinite || limits.ponderMode;
+    engine.go(limits);
+}
+
+// bench [depth]: searches a fixed set of positions to a fixed depth and
+// reports the nodes and the speed, to compare builds. The game is replaced.
+void UCIEngine::bench(std::istream& args) {
+    int depth = BenchDepth;
+    args >> depth;
+
+    uint64_t  nodes = 0;
+    TimePoint start = now();
+
+    engine.set_on_bestmove([&](const SearchResult& r) { nodes += r.nodes; });
+    for (const std::string& fen : BenchFens) {
+        engine.search_clear();
+        engine.set_position(fen, {});
+        print("\nPosition: " + fen + "\n");
+
+        Search::LimitsType limits;
+        limits.depth = depth;
+        engine.go(limits);
+        engine.wait_for_search_finished();
+    }
+    init_search_update_listeners();
+
+    TimePoint elapsed = now() - start + 1;  // never zero
+    print("\nTotal time (ms) : " + std::to_string(elapsed) +
+          "\nNodes searched  : " + std::to_string(nodes) +
+          "\nNodes/second    : " + std::to_string(1000 * nodes / elapsed) + "\n");
+}
+
+// position startpos [moves <m1> <m2> ...]
+// position fen <fen> [moves ...]
+// position <fen> [moves ...]
+void UCIEngine::position(std::istringstream& is) {
+    std::string              token, fen;
+    std::vector<std::string> moves;
+
+    while (is >> token && token != "moves")
+        if (token == "startpos") fen = StartFEN;
+        else if (token != "fen") fen += (fen.empty() ? "" : " ") + token;
+    while (is >> token) moves.push_back(token);
+
+    if (fen.empty()) {
+        print_info_string("error: position requires FEN or startpos");
+        return;
+    }
+
+    std::string error = engine.set_position(fen, moves);
+    print_info_string(error.empty() ? "position set" : "error: " + error);
+}
+
+// setoption name Hash value <MB>
+// setoption name Threads value <N>
+// setoption name Bitbase value <path>   ("<empty>" to close it)
+// setoption name PonderReplies value <N>
+void UCIEngine::setoption(std::istringstream& is) {
+    std::string token, name, value;
+
+    is >> token;  // "name"
+    while (is >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    while (is >> token) value += (value.empty() ? "" : " ") + token;
+
+    if (name == "Hash" || name == "Threads" || name == "PonderReplies") {
+        size_t n;
+        try {
+            n = std::stoul(value);
+        } catch (...) {
+            print_info_string("error: bad " + name + " value");
+            return;
+        }
+        if (name == "Hash") {
+            engine.set_hash(n);
+            print_info_string("hash " + std::to_string(TT.size_mb()) + " MB");
+        } else if (name == "Threads") {
+            engine.set_threads(n);
+            print_info_string("threads " + std::to_string(Threads.size()));
+        } else {
+            n = std::min(n, size_t(16));
+            engine.set_ponder_replies(int(n));
+            print_info_string("ponder replies " + std::to_string(n));
+        }
+    } else if (name == "Bitbase") {
+        if (value == "<empty>" || value.empty()) {
+            engine.load_bitbase("");
+            print_info_string("bitbase closed");
+        } else if (int rc = engine.load_bitbase(value))
+            print_info_string("error: cannot load bitbase (rc=" + std::to_string(rc) + ")");
+        else
+            print_info_string("bitbase " + std::to_string(tb::Bitbases.size()) + " positions");
+    } else if (name == "Ponder") {
+        // Only tells whether the GUI will send go ponder
+    } else
+        print_info_string("error: unknown option");
+}
+
+// perft N [threads T] [hash MB]
+void UCIEngine::perft(std::istringstream& is) {
+    std::vector<std::string> toks;
+    std::string              token;
+    while (is >> token) toks.push_back(token);
+
+    int    depth   = 1;
+    size_t threads = 1, hashMB = 0;
+    try {
+        if (!toks.empty()) depth = std::stoi(toks[0]);
+        for (size_t i = 1; i + 1 < toks.size(); ++i) {
+            if (toks[i] == "threads") threads = std::stoul(toks[i + 1]);
+            if (toks[i] == "hash") hashMB = std::stoul(toks[i + 1]);
+        }
+    } catch (...) {
+        print_info_string("error: perft N [threads T] [hash MB]");
+        return;
+    }
+    engine.perft(depth, threads, hashMB);
+}
+
+void UCIEngine::on_iter(const SearchResult& r) {
+    print("info depth " + std::to_string(r.depth) + " score " + std::to_string(r.score) +
+          " nodes " + std::to_string(r.nodes) + " time " + std::to_string(r.time) + " pv " +
+          to_string(r.bestMove) + "\n");
+}
+
+void UCIEngine::on_bestmove(const SearchResult& r) {
+    if (r.bestMove == MOVE_NONE) {
+        print("bestmove none score 0\n");
+        return;
+    }
+
+    std::ostringstream os;
+    os << "info string nodes " << r.nodes << " tthits " << r.ttHits << "/" << r.ttProbes << " ("
+       << (r.ttProbes ? 100 * r.ttHits / r.ttProbes : 0) << "%) hashfull " << r.hashfull
+       << " tbhits " << r.tbHits << "\n"
+       << "bestmove " << to_string(r.bestMove);
+    if (r.ponderMove) os << " ponder " << to_string(r.ponderMove);
+    os << " score " << r.score << "\n";
+    print(os.str());
+}
+
+}  // namespace tiny
@@ -21,56 +21,47 @@
 
 #include <cstdint>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <string_view>
 
+#include "../minmax/minmax.h"
 #include "engine.h"
 #include "misc.h"
-#include "search.h"
 
 namespace tiny {
 
-class Position;
-class Move;
-class Score;
-enum Square : int8_t;
-using Value = int;
-
+// UCIEngine reads commands from stdin and answers on stdout. A search runs on
+// the engine's own thread, so this loop goes on reading while it thinks and
+// answers isready, stop and ponderhit at once.
+//
+// Besides UCI, answers keep the form the tools around the engine read:
+// "bestmove <move> score <value>", with the value in material units from the
+// side to move, and "bestmove none score 0" when there is no legal move.
 class UCIEngine {
    public:
     UCIEngine(int argc, char** argv);
 
     void loop();
 
-    static int         to_cp(Value v, const Position& pos);
-    static std::string format_score(const Score& s);
-    static std::string square(Square s);
-    static std::string move(Move m, bool chess960);
-    static std::string wdl(Value v, const Position& pos);
-    static std::string to_lower(std::string str);
-    static Move        to_move(const Position& pos, std::string str);
-
     static Search::LimitsType parse_limits(std::istream& is);
 
-    auto& engine_options() { return engine.get_options(); }
-
    private:
     Engine      engine;
-    CommandLine cli;
+    std::string commandLine;  // run instead of reading stdin, if given
+    bool        unbounded = false;  // the last go was infinite or ponder
 
+    static void print(const std::string& str);
     static void print_info_string(std::string_view str);
 
-    void          go(std::istringstream& is);
-    void          bench(std::istream& args);
-    void          benchmark(std::istream& args);
-    void          position(std::istringstream& is);
-    void          setoption(std::istringstream& is);
-    std::uint64_t perft(const Search::LimitsType&);
-
-    static void on_update_no_moves(const Engine::InfoShort& info);
-    static void on_update_full(const Engine::InfoFull& info, bool showWDL);
-    static void on_iter(const Engine::InfoIter& info);
-    static void on_bestmove(std::string_view bestmove, std::string_view ponder);
+    void go(std::istringstream& is);
+    void bench(std::istream& args);
+    void position(std::istringstream& is);
+    void setoption(std::istringstream& is);
+    void perft(std::istringstream& is);
+
+    static void on_iter(const SearchResult& r);
+    static void on_bestmove(const SearchResult& r);
 
     void init_search_update_listeners();
 };
@@ -0,0 +1,130 @@
+#include "unmovegen.h"
+
+#include <cassert>
+#include <initializer_list>
+
+#include "bitboard.h"
+#include "position.h"
+
+namespace tiny {
+
+namespace {
+
+// Tests whether the king of the side to move is safe in the predecessor where
+// the piece of the other side on 'to' stood on 'from' as a 'pt', or was still
+// in the pocket if from == SQ_NONE, and 'to' held a captured piece or not. The
+// attackers are looked up on the current board with the predecessor occupancy,
+// which is exact for everything but the retracted piece itself.
+bool safe_predecessor(const Position& pos, Square from, Square to, PieceType pt, bool capture) {
+    const Color  us   = pos.side_to_move();
+    const Color  them = ~us;
+    const Square ksq  = pos.square<KING>(us);
+
+    Bitboard occupied = pos.pieces() ^ to;
+    if (from != SQ_NONE) occupied |= from;
+    if (capture) occupied |= to;
+
+    if (pos.attackers_to(ksq, occupied) & pos.pieces(them) & ~square_bb(to)) return false;
+
+    return from == SQ_NONE || !((pt == PAWN ? attacks_bb<PAWN>(from, them)
+                                            : attacks_bb(pt, from, occupied)) &
+                                ksq);
+}
+
+// Adds the retractions of move m: the quiet one and/or one per piece the
+// mover may have captured on the destination square, read from its pocket.
+// A pawn in the pocket may have been a pawn or a promoted piece on the board.
+UnMove* splat_unmoves(const Position& pos, UnMove* unmoveList, Move m, bool quiet, bool captures) {
+    const Color  us   = pos.side_to_move();
+    const Color  them = ~us;
+    const Square to   = m.to_sq();
+
+    if (quiet) *unmoveList++ = {m, NO_PIECE, false};
+
+    if (captures)
+        for (PieceType pt = PAWN; pt <= WAZIR; ++pt) {
+            if (!pos.pocket(them).count(pt)) continue;
+
+            if (pt != PAWN || relative_rank(us, to) != RANK_4)
+                *unmoveList++ = {m, make_piece(us, pt), false};
+
+            if (pt == PAWN)
+                for (PieceType promoted : {HORSE, FERZ, WAZIR})
+                    *unmoveList++ = {m, make_piece(us, promoted), true};
+        }
+
+    return unmoveList;
+}
+
+// Adds the retractions of the piece on 'to' back to the empty squares in
+// 'quietFrom' (as a non-capture) and 'captureFrom' (as a capture). 'pt' is the
+// type of the piece before the move, a pawn for promotions.
+template <MoveType T>
+UnMove* generate_origins(const Position& pos, UnMove* unmoveList, Square to, PieceType pt,
+                         Bitboard quietFrom, Bitboard captureFrom) {
+    const PieceType onBoard = type_of(pos.piece_on(to));
+
+    for (Bitboard b = quietFrom | captureFrom; b;) {
+        Square from = pop_lsb(b);
+        Move   m = T == PROMOTION ? Move::make<PROMOTION>(from, to, onBoard) : Move(from, to);
+
+        bool quiet    = (quietFrom & from) && safe_predecessor(pos, from, to, pt, false);
+        bool captures = (captureFrom & from) && safe_predecessor(pos, from, to, pt, true);
+
+        unmoveList = splat_unmoves(pos, unmoveList, m, quiet, captures);
+    }
+
+    return unmoveList;
+}
+
+}  // namespace
+
+// Generates all un-moves of the side that just moved (the side not to move):
+// un-drops back to the pocket, board moves back to an empty square, possibly
+// giving back a captured piece, and un-promotions of promoted pawns standing
+// on the last rank.
+UnMove* generate_unmoves(const Position& pos, UnMove* unmoveList) {
+    const Color    us      = pos.side_to_move();
+    const Color    them    = ~us;
+    const Bitboard empties = ~pos.pieces();
+
+    // The side that just moved cannot have left its king in check
+    if (pos.attackers_to_exist(pos.square<KING>(them), pos.pieces(), us)) return unmoveList;
+
+    for (Bitboard b = pos.pieces(them); b;) {
+        const Square    to       = pop_lsb(b);
+        const PieceType pt       = type_of(pos.piece_on(to));
+        const bool      promoted = pos.promoted_pawns() & to;
+
+        // Un-drops: pockets hold at most two pieces of a type, and promoted
+        // pieces are never dropped
+        if (pt != KING && !promoted && pos.pocket(them).count(pt) < 2 &&
+            safe_predecessor(pos, SQ_NONE, to, pt, false))
+            *unmoveList++ = {Move::make<DROP>(to, to, pt), NO_PIECE, false};
+
+        // Pawns only capture diagonally, everything else moves and captures
+        // the same way. Horse moves need the leg free, which retracting the
+        // move does not change.
+        Bitboard quietFrom, captureFrom;
+        if (pt == PAWN) {
+            quietFrom   = relative_rank(them, to) != RANK_1 ? square_bb(to - pawn_push(them)) : 0;
+            captureFrom = attacks_bb<PAWN>(to, us);
+        } else if (pt == HORSE)
+            quietFrom = captureFrom = horse_attackers_bb(to, pos.pieces());
+        else
+            quietFrom = captureFrom = attacks_bb(pt, to, pos.pieces());
+
+        unmoveList = generate_origins<NORMAL>(pos, unmoveList, to, pt, quietFrom & empties,
+                                              captureFrom & empties);
+
+        // Un-promotions
+        if (promoted && relative_rank(them, to) == RANK_4)
+            unmoveList = generate_origins<PROMOTION>(pos, unmoveList, to, PAWN,
+                                                     square_bb(to - pawn_push(them)) & empties,
+                                                     attacks_bb<PAWN>(to, us) & empties);
+    }
+
+    return unmoveList;
+}
+
+}  // namespace tiny
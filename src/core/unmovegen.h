@@ -0,0 +1,42 @@
+// unmovegen.h
+#ifndef UNMOVEGEN_H_INCLUDED
+#define UNMOVEGEN_H_INCLUDED
+
+#include <cstddef>
+
+#include "types.h"
+
+namespace tiny {
+
+class Position;
+
+// UnMove describes one way a position can have been reached: the move, as
+// played in the predecessor, and the piece it captured, if any. Retracting it
+// with Position::retract() gives the predecessor.
+struct UnMove {
+    Move  move;
+    Piece captured;          // NO_PIECE for quiet moves and drops
+    bool  capturedPromoted;  // The captured piece was a promoted pawn
+};
+
+constexpr int MAX_UNMOVES = 512;
+
+// Generates the un-moves of pos: every legal position with the other side to
+// move, together with the legal move that leads from it to pos. Returns a
+// pointer to the end of the list.
+UnMove* generate_unmoves(const Position& pos, UnMove* unmoveList);
+
+// The UnMoveList struct wraps generate_unmoves(), in the same way as MoveList
+struct UnMoveList {
+    explicit UnMoveList(const Position& pos) : last(generate_unmoves(pos, unmoveList)) {}
+    const UnMove* begin() const { return unmoveList; }
+    const UnMove* end() const { return last; }
+    size_t        size() const { return last - unmoveList; }
+
+   private:
+    UnMove unmoveList[MAX_UNMOVES], *last;
+};
+
+}  // namespace tiny
+
+#endif  // #ifndef UNMOVEGEN_H_INCLUDED
@@ -14,9 +14,6 @@ using namespace tiny;
 static inline const char* color_name(Color c) { return c == WHITE ? "White" : "Black"; }
 
 int main() {
-    Bitboards::init();
-    Position::init();
-
     Position              pos;
     std::deque<StateInfo> states;  // Container to manage StateInfo objects
 
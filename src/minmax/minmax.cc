@@ -1,7 +1,85 @@
 #include "minmax.h"
 
+#include <algorithm>
+#include <cstdlib>
+
+#include "../solve/tb_bitbase.h"
+#include "thread.h"
+#include "tt.h"
+
 namespace tiny {
 
+namespace {
+
+// Adjusts a mate score from "plies to mate from the root" to
+// "plies to mate from the current position". Standard scores are unchanged.
+// The function is called before storing a value in the transposition table.
+Value value_to_tt(Value v, int ply) {
+    return v >= VALUE_MATE_IN_MAX_PLY ? v + ply : v <= VALUE_MATED_IN_MAX_PLY ? v - ply : v;
+}
+
+// Inverse of value_to_tt(): it adjusts a mate score from the transposition
+// table (which refers to the plies to mate from the position where it was
+// stored) to "plies to mate from the current position".
+Value value_from_tt(Value v, int ply) {
+    if (v == VALUE_NONE) return VALUE_NONE;
+
+    return v >= VALUE_MATE_IN_MAX_PLY ? v - ply : v <= VALUE_MATED_IN_MAX_PLY ? v + ply : v;
+}
+
+// Moves the TT move, if it is among the legal moves, to the front of the list
+// so it is searched first.
+void tt_move_first(ExtMove* begin, ExtMove* end, Move ttMove) {
+    ExtMove* it = std::find(begin, end, ttMove);
+    if (ttMove && it != end) std::rotate(begin, it, it + 1);
+}
+
+// History bonus for a quiet move that caused a cut-off at the given depth
+int stat_bonus(int depth) { return std::min(depth * depth * 16, 2048); }
+
+// Sizes and phases of the skip blocks, used for distributing search depths
+// across the helper threads so that they do not all search the same depth
+constexpr int SkipSize[]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int SkipPhase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// Quiescence search depths: checking drops are only tried on its first ply,
+// so that sequences of checks end. Both fit the TT's depth offset.
+constexpr int DEPTH_QS_CHECKS    = 0;
+constexpr int DEPTH_QS_NO_CHECKS = -1;
+
+// Whether the quiescence search tries checking drops at all
+constexpr bool QSearchCheckDrops = true;
+
+// A capture is not searched if even this much above what it wins would not
+// bring the score up to alpha
+constexpr Value DeltaMargin = PawnValue;
+
+// Pondering searches all the replies up to this depth to rank them
+constexpr int PonderRankDepth = 3;
+
+// Under a root the bitbase says is won, the positions the winner still wins
+// are searched on and the others cut off, so the scores depend on the root.
+// They go to the TT under keys of their own, one for the positions the
+// winner is to move in and one for the others, so that searches from other
+// roots do not take them for their own.
+constexpr Key TbWinnerKeys[2] = {0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL};
+
+// The side the bitbase says wins from root, or COLOR_NB
+Color tb_winner(const Position& root) {
+    retro::WDL wdl;
+    if (!tb::Bitbases.is_open() || !tb::Bitbases.probe(root, wdl) || wdl == retro::WDL::Draw)
+        return COLOR_NB;
+    return wdl == retro::WDL::Win ? root.side_to_move() : ~root.side_to_move();
+}
+
+// TT key of pos in a search whose root is won by tbWinner, see TbWinnerKeys
+Key tt_key(const Position& pos, Color tbWinner, Symmetry& sym) {
+    const Key key = pos.canonical_key(sym);
+    return tbWinner == COLOR_NB ? key : key ^ TbWinnerKeys[pos.side_to_move() == tbWinner];
+}
+
+}  // namespace
+
 // Material-only evaluation, side-to-move perspective.
 // Positive means the side to move is better.
 Value evaluate(const Position& pos) {
@@ -22,18 +100,105 @@ Value evaluate(const Position& pos) {
     return diff;
 }
 
+namespace {
+
+// Scores a position the bitbase says winner still wins, from the side to
+// move. The bitbase has no distances, so the evaluation orders these lines,
+// but a winner who is behind in material must still prefer them to a draw.
+Value tb_win_value(const Position& pos, Color winner) {
+    Value v = std::clamp(evaluate(pos), -EVAL_MAX, EVAL_MAX);
+    return pos.side_to_move() == winner ? VALUE_TB_WIN_LINE + v : -VALUE_TB_WIN_LINE + v;
+}
+
+}  // namespace
+
 // Core negamax with alpha-beta pruning.
 // Returns a score from the perspective of the side to move in 'pos'.
-Value negamax(Position& pos, int depth, int alpha, int beta, int ply) {
+Value Search::Worker::negamax(Position& pos, int depth, Value alpha, Value beta, int ply) {
+    // At the horizon the captures are played out
+    if (depth <= 0) return qsearch(pos, alpha, beta, ply);
+
+    // Only this thread writes its counter, no need for a read-modify-write
+    const uint64_t n = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(n, std::memory_order_relaxed);
+
+    if (limits.nodes && n >= limits.nodes) threads.stop = true;
+    if ((n & 1023) == 0 && is_main()) check_time();
+
+    if (threads.stop.load(std::memory_order_relaxed)) return VALUE_ZERO;
+
     // Repetition draw
     if (pos.is_draw(ply)) return VALUE_DRAW;
 
-    if (depth == 0) return evaluate(pos);
+    Value tbValue;
+    bool  tbWon;
+    if (probe_bitbase(pos, tbValue, tbWon)) return tbValue;
 
-    MoveList<LEGAL> moves(pos);
+    // Transposition table lookup. Symmetric positions share an entry, whose
+    // move is stored in the frame of the canonical image.
+    Symmetry  sym;
+    const Key posKey    = tt_key(pos, tbWinner, sym);
+    const int alphaOrig = alpha;
+    bool      ttHit;
+    TTData    ttData;
+    TTEntry*  tte     = TT.probe(posKey, ttHit, ttData);
+    Value     ttValue = ttHit ? value_from_tt(ttData.value, ply) : VALUE_NONE;
+    Move      ttMove  = transform(ttData.move, sym);
+
+    ++ttProbes;
+    ttHits += ttHit;
+
+    // A deep enough TT bound that already decides the window ends the node
+    if (ttHit && ttData.depth >= depth && ttValue != VALUE_NONE &&
+        (ttData.bound & (ttValue >= beta ? BOUND_LOWER : BOUND_UPPER)))
+        return ttValue;
+
+    MovePicker mp(pos, ttMove, &mainHistory, killers[ply]);
+
+    int  best       = -VALUE_INFINITE;  // track true best value found
+    Move bestMove   = Move::none();
+    int  moveCount  = 0;
+    int  quietCount = 0;
+    Move quietsSearched[64];
+    Move m;
+
+    while ((m = mp.next_move()) != Move::none()) {
+        if (!pos.legal(m)) continue;
+
+        ++moveCount;
+        bool quiet = !pos.capture(m) && m.type_of() != PROMOTION;
+
+        StateInfo st;
+        pos.do_move(m, st);
+
+        // Negamax flip and window flip
+        int score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+
+        pos.undo_move(m);
+
+        // An aborted subtree returns garbage, never let it reach the TT
+        if (threads.stop.load(std::memory_order_relaxed)) return VALUE_ZERO;
+
+        if (score > best) {
+            best     = score;
+            bestMove = m;
+        }
+        if (score > alpha) {
+            alpha = score;
+            // beta cutoff
+            if (alpha >= beta) {
+                if (quiet)
+                    update_quiet_stats(pos.side_to_move(), m, quietsSearched, quietCount, depth,
+                                       ply);
+                break;
+            }
+        }
+
+        if (quiet && quietCount < 64) quietsSearched[quietCount++] = m;
+    }
 
     // No legal moves: terminal
-    if (moves.size() == 0) {
+    if (!moveCount) {
         if (pos.checkers()) {
             // Checkmate: side to move loses
             return -VALUE_MATE + ply;  // prefer quicker mates against us
@@ -43,64 +208,356 @@ Value negamax(Position& pos, int depth, int alpha, int beta, int ply) {
         }
     }
 
-    int best = -VALUE_INFINITE;  // track true best value found
+    Bound bound = best >= beta ? BOUND_LOWER : best > alphaOrig ? BOUND_EXACT : BOUND_UPPER;
+    tte->save(posKey, value_to_tt(best, ply), bound, depth,
+              transform(bound == BOUND_UPPER ? ttMove : bestMove, sym), TT.generation());
 
-    for (const Move& m : moves) {
-        StateInfo st;
-        pos.do_move(m, st);
+    return best;
+}
 
-        // Negamax flip and window flip
-        int score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+// Quiescence search: only captures, promotions and, on its first ply,
+// checking drops are searched, until the position is quiet enough for the
+// evaluation. In crazyhouse every capture comes back as a drop, so stopping
+// in the middle of an exchange misjudges the position badly. Out of check
+// the side to move may stand pat instead of playing any of these moves.
+Value Search::Worker::qsearch(Position& pos, Value alpha, Value beta, int ply, int depth) {
+    const uint64_t n = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(n, std::memory_order_relaxed);
+
+    if (limits.nodes && n >= limits.nodes) threads.stop = true;
+    if ((n & 1023) == 0 && is_main()) check_time();
+
+    if (threads.stop.load(std::memory_order_relaxed)) return VALUE_ZERO;
+
+    if (pos.is_draw(ply)) return VALUE_DRAW;
+
+    Value tbValue;
+    bool  tbWon;
+    if (probe_bitbase(pos, tbValue, tbWon)) return tbValue;
+
+    if (ply >= MAX_PLY - 1) return tbWon ? tb_win_value(pos, tbWinner) : evaluate(pos);
+
+    Symmetry  sym;
+    const Key posKey    = tt_key(pos, tbWinner, sym);
+    const int alphaOrig = alpha;
+    bool      ttHit;
+    TTData    ttData;
+    TTEntry*  tte     = TT.probe(posKey, ttHit, ttData);
+    Value     ttValue = ttHit ? value_from_tt(ttData.value, ply) : VALUE_NONE;
+    Move      ttMove  = transform(ttData.move, sym);
+
+    ++ttProbes;
+    ttHits += ttHit;
+
+    if (ttHit && ttData.depth >= depth && ttValue != VALUE_NONE &&
+        (ttData.bound & (ttValue >= beta ? BOUND_LOWER : BOUND_UPPER)))
+        return ttValue;
 
+    const bool inCheck = pos.checkers();
+    Value      standPat = -VALUE_INFINITE, best = -VALUE_INFINITE;
+    if (!inCheck) {
+        standPat = best = tbWon ? tb_win_value(pos, tbWinner) : evaluate(pos);
+        if (best >= beta) return best;
+        alpha = std::max(alpha, best);
+    }
+
+    MovePicker mp(pos, ttMove, &mainHistory, QSearchCheckDrops && depth == DEPTH_QS_CHECKS);
+    Move       bestMove  = Move::none();
+    int        moveCount = 0;
+    Move       m;
+
+    while ((m = mp.next_move()) != Move::none()) {
+        if (!pos.legal(m)) continue;
+
+        ++moveCount;
+
+        // Delta pruning. A capture wins the victim twice, off the board and
+        // into our pocket. Checks are always searched.
+        if (!inCheck && m.type_of() != DROP && !pos.gives_check(m)) {
+            Value gain = pos.capture(m) ? 2 * type_value(type_of(pos.piece_on(m.to_sq()))) : 0;
+            if (m.type_of() == PROMOTION) gain += type_value(m.promotion_type()) - PawnValue;
+            if (standPat + gain + DeltaMargin <= alpha) {
+                best = std::max(best, standPat + gain + DeltaMargin);
+                continue;
+            }
+        }
+
+        StateInfo st;
+        pos.do_move(m, st);
+        Value score = -qsearch(pos, -beta, -alpha, ply + 1, DEPTH_QS_NO_CHECKS);
         pos.undo_move(m);
 
-        if (score > best) best = score;
+        if (threads.stop.load(std::memory_order_relaxed)) return VALUE_ZERO;
+
+        if (score > best) {
+            best     = score;
+            bestMove = m;
+        }
         if (score > alpha) {
             alpha = score;
-            // beta cutoff
             if (alpha >= beta) break;
         }
     }
 
-    return best;
-}
+    // Checkmate. A stalemate is not looked for, as out of check not all
+    // the moves are generated.
+    if (inCheck && !moveCount) return -VALUE_MATE + ply;
 
-// Returns the best move and its score for the current position.
-SearchResult search_best_move(Position& pos, int depth) {
-    MoveList<LEGAL> moves(pos);
+    Bound bound = best >= beta ? BOUND_LOWER : best > alphaOrig ? BOUND_EXACT : BOUND_UPPER;
+    tte->save(posKey, value_to_tt(best, ply), bound, depth,
+              transform(bound == BOUND_UPPER ? ttMove : bestMove, sym), TT.generation());
 
-    // Handle immediate terminals at root
-    if (moves.size() == 0) {
-        int terminalScore =
-            pos.checkers() ? (-VALUE_MATE /* + ply=0 */) : (+VALUE_MATE /* - ply=0 */);
-        return {MOVE_NONE, terminalScore};
-    }
-    if (pos.is_draw(/*ply=*/0)) return {MOVE_NONE, VALUE_DRAW};
+    return best;
+}
 
+// Searches all root moves in [begin, end) to the given depth. The list is
+// kept ordered with the best move of the previous iteration in front.
+Value Search::Worker::search_root(Position& pos, int depth, ExtMove* begin, ExtMove* end,
+                                  Move& bestMove) {
     int alpha = -VALUE_MATE;
     int beta  = +VALUE_MATE;
 
-    Move bestMove  = MOVE_NONE;
-    int  bestScore = -VALUE_MATE;
+    int bestScore = -VALUE_MATE;
 
-    for (const Move& m : moves) {
+    for (ExtMove* m = begin; m != end; ++m) {
         StateInfo st;
-        pos.do_move(m, st);
+        pos.do_move(*m, st);
 
         int score = -negamax(pos, depth - 1, -beta, -alpha, 1);
 
-        pos.undo_move(m);
+        pos.undo_move(*m);
+
+        if (threads.stop) break;
 
         if (score > bestScore) {
             bestScore = score;
-            bestMove  = m;
+            bestMove  = *m;
         }
         if (score > alpha) {
             alpha = score;
         }
     }
 
-    return {bestMove, bestScore};
+    return bestScore;
+}
+
+// Rewards the quiet move that caused a cut-off and penalizes the quiets
+// searched before it. The move also becomes the first killer of this ply.
+void Search::Worker::update_quiet_stats(Color us, Move bestMove, const Move* quiets,
+                                        int quietCount, int depth, int ply) {
+    int bonus = stat_bonus(depth);
+
+    mainHistory.update(us, bestMove, bonus);
+    for (int i = 0; i < quietCount; ++i) mainHistory.update(us, quiets[i], -bonus);
+
+    if (killers[ply][0] != bestMove) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = bestMove;
+    }
+}
+
+// Looks pos up in the bitbase, if one is open. The bitbase has no distances,
+// so a win cannot be played out from it: positions the side winning from the
+// root still wins are searched on, to find the mate, with tbWon set so that
+// their evaluation is lifted above the draws. The others, which that side
+// should avoid, are cut off with their bitbase value.
+bool Search::Worker::probe_bitbase(const Position& pos, Value& value, bool& tbWon) {
+    retro::WDL wdl;
+    tbWon = false;
+    if (!tb::Bitbases.is_open() || !tb::Bitbases.probe(pos, wdl)) return false;
+
+    const Color us = pos.side_to_move();
+    if ((wdl == retro::WDL::Win && us == tbWinner) || (wdl == retro::WDL::Loss && ~us == tbWinner)) {
+        tbWon = true;
+        return false;
+    }
+
+    ++tbHits;
+    value = wdl == retro::WDL::Win    ? VALUE_TB_WIN
+            : wdl == retro::WDL::Loss ? VALUE_TB_LOSS
+                                      : VALUE_DRAW;
+    return true;
+}
+
+// Called by the main thread every 1024 nodes to see whether the time budget
+// or the node budget of all threads together is used up.
+void Search::Worker::check_time() {
+    // While pondering the clock is the opponent's
+    if ((!threads.ponder && tm.maximum() && tm.elapsed() >= tm.maximum()) ||
+        (limits.nodes && threads.nodes_searched() >= limits.nodes))
+        threads.stop = true;
+}
+
+// Deepens the search one ply at a time until a limit is hit. Only completed
+// iterations update the answer, and each iteration starts from the best move
+// of the previous one. Helpers skip some depths, depending on their index, so
+// the threads spread over several depths and fill the shared TT for each
+// other.
+SearchResult Search::Worker::iterative_deepening(Position& pos, const IterationCallback& onIter) {
+    tm.init(limits, pos.side_to_move());
+    mainHistory.clear();
+    std::fill(&killers[0][0], &killers[0][0] + MAX_PLY * 2, Move::none());
+
+    MoveList<LEGAL> moves(pos);
+    SearchResult    result{MOVE_NONE, MOVE_NONE, VALUE_ZERO, 0, 0, 0, 0, 0, 0, 0};
+
+    // Handle immediate terminals at root
+    if (moves.size() == 0) {
+        result.score = pos.checkers() ? (-VALUE_MATE /* + ply=0 */) : (+VALUE_MATE /* - ply=0 */);
+        return lastResult = result;
+    }
+    if (pos.is_draw(/*ply=*/0)) {
+        result.score = VALUE_DRAW;
+        return lastResult = result;
+    }
+
+    // A root the bitbase knows to be won is searched towards the mate
+    tbWinner = tb_winner(pos);
+
+    Symmetry  sym;
+    const Key rootKey = tt_key(pos, tbWinner, sym);
+    bool      ttHit;
+    TTData    ttData;
+    TTEntry*  tte = TT.probe(rootKey, ttHit, ttData);
+    tt_move_first(moves.begin(), moves.end(), transform(ttData.move, sym));
+
+    // Always have something to play, even if the first iteration is aborted
+    result.bestMove = moves[0];
+
+    const int maxDepth = limits.depth ? std::min(limits.depth, MAX_SEARCH_DEPTH) : MAX_SEARCH_DEPTH;
+
+    for (int depth = 1; depth <= maxDepth && !threads.stop; ++depth) {
+        if (!is_main()) {
+            int i = (idx - 1) % 20;
+            if (((depth + SkipPhase[i]) / SkipSize[i]) % 2) continue;
+        }
+
+        TimePoint iterStart = tm.elapsed();
+        Move      bestMove  = MOVE_NONE;
+        Value     score     = search_root(pos, depth, moves.begin(), moves.end(), bestMove);
+
+        if (threads.stop) break;
+
+        // Search the best move of this iteration first in the next one
+        tt_move_first(moves.begin(), moves.end(), bestMove);
+
+        tte = TT.probe(rootKey, ttHit, ttData);
+        tte->save(rootKey, value_to_tt(score, 0), BOUND_EXACT, depth, transform(bestMove, sym),
+                  TT.generation());
+
+        result.bestMove = bestMove;
+        result.score    = score;
+        result.depth    = depth;
+        result.nodes    = is_main() ? threads.nodes_searched() : nodes_searched();
+        result.ttProbes = ttProbes;
+        result.ttHits   = ttHits;
+        result.tbHits   = tbHits;
+        result.hashfull = TT.hashfull();
+        result.time     = tm.elapsed();
+
+        lastResult = result;
+        if (onIter) onIter(result);
+
+        // A mate (or being mated) within the searched depth will not change
+        if (!limits.infinite && std::abs(score) >= VALUE_MATE_IN_MAX_PLY &&
+            VALUE_MATE - std::abs(score) <= depth)
+            break;
+
+        // Do not start an iteration we expect to be aborted: the next one
+        // takes at least as long as this one did.
+        if (is_main() && limits.use_time_management() && !threads.ponder) {
+            TimePoint elapsed = tm.elapsed();
+            if (elapsed >= tm.optimum() || elapsed + (elapsed - iterStart) > tm.maximum()) break;
+        }
+    }
+
+    result.nodes    = nodes_searched();
+    result.ttProbes = ttProbes;
+    result.ttHits   = ttHits;
+    result.tbHits   = tbHits;
+    result.time     = tm.elapsed();
+
+    return lastResult = result;
+}
+
+SearchResult search(Position& pos, const Search::LimitsType& limits,
+                    const Search::IterationCallback& onIter) {
+    // Callers that never configured the table get the default size
+    if (!TT.size_mb()) TT.resize(DEFAULT_HASH_MB);
+
+    TT.new_search();
+
+    Threads.reset_flags(limits.ponderMode);
+    return Threads.start_thinking(pos, limits, onIter);
+}
+
+// Returns the best move and its score for the current position.
+SearchResult search_best_move(Position& pos, int depth) {
+    Search::LimitsType limits;
+    limits.depth = depth;
+
+    return search(pos, limits);
+}
+
+Move expected_reply(Position& pos, Move m) {
+    if (!m) return Move::none();
+
+    const Color tbWinner = tb_winner(pos);
+
+    StateInfo st;
+    pos.do_move(m, st);
+
+    Symmetry  sym;
+    const Key key = tt_key(pos, tbWinner, sym);
+    bool      ttHit;
+    TTData    ttData;
+    TT.probe(key, ttHit, ttData);
+
+    Move reply = Move::none();
+    if (ttHit)
+        for (Move r : MoveList<LEGAL>(pos))
+            if (r == transform(ttData.move, sym)) reply = r;
+
+    pos.undo_move(m);
+    return reply;
+}
+
+void ponder_replies(Position& pos, Move expected, int replies) {
+    struct Reply {
+        Move  move;
+        Value score;  // ours, after it
+    };
+    std::vector<Reply> candidates;
+    for (Move m : MoveList<LEGAL>(pos)) candidates.push_back({m, VALUE_ZERO});
+
+    // The expected reply stays first, whatever the scores say
+    auto   it    = std::find_if(candidates.begin(), candidates.end(),
+                                [&](const Reply& r) { return r.move == expected; });
+    size_t fixed = it != candidates.end();
+    if (fixed) std::rotate(candidates.begin(), it, it + 1);
+
+    Threads.begin_speculation();
+    for (int depth = 1; depth <= MAX_SEARCH_DEPTH && Threads.resume_speculation(); ++depth) {
+        const size_t n = replies > 0 && depth <= PonderRankDepth
+                           ? candidates.size()
+                           : std::min(candidates.size(), fixed + size_t(std::max(replies, 0)));
+
+        for (size_t i = 0; i < n && Threads.resume_speculation(); ++i) {
+            Search::LimitsType limits;
+            limits.depth = depth;
+
+            StateInfo st;
+            pos.do_move(candidates[i].move, st);
+            SearchResult r = Threads.start_thinking(pos, limits, nullptr);
+            pos.undo_move(candidates[i].move);
+
+            if (r.depth) candidates[i].score = r.score;
+        }
+
+        std::stable_sort(candidates.begin() + fixed, candidates.end(),
+                         [](const Reply& a, const Reply& b) { return a.score < b.score; });
+    }
+    Threads.end_speculation();
 }
 }  // namespace tiny
 
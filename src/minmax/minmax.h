@@ -2,23 +2,137 @@
 #ifndef MINMAX_H_INCLUDED
 #define MINMAX_H_INCLUDED
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../core/misc.h"
 #include "../core/movegen.h"   // For MoveList
 #include "../core/position.h"  // For Position class
 #include "../core/types.h"     // For Move, Score typedefs, etc.
+#include "movepick.h"
+#include "timeman.h"
 
 namespace tiny {
 
+class ThreadPool;
+
 // Constants
 
 constexpr Move MOVE_NONE = Move::none();
 
+constexpr size_t DEFAULT_HASH_MB  = 16;
+constexpr int    MAX_SEARCH_DEPTH = 64;
+
 // Simple search wrapper for a single PV move at the root.
 struct SearchResult {
     Move  bestMove;
+    Move  ponderMove;  // the reply expected to bestMove, if the TT knows one
     Value score;
+
+    // Search statistics
+    uint64_t nodes;
+    uint64_t ttProbes;
+    uint64_t ttHits;
+    uint64_t tbHits;    // positions answered by the bitbase
+    int      hashfull;  // permille of the TT written by this search
+    int      depth;     // last fully completed iteration
+    TimePoint time;     // ms spent so far
+};
+
+namespace Search {
+
+// LimitsType struct stores information sent by the caller about available time
+// to search the current move, maximum depth/time, or if we are in analysis mode.
+// A default constructed LimitsType searches until depth MAX_SEARCH_DEPTH.
+struct LimitsType {
+    LimitsType() {
+        time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = movetime = TimePoint(0);
+        startTime = now();
+        depth     = 0;
+        nodes      = 0;
+        infinite   = false;
+        ponderMode = false;
+    }
+
+    bool use_time_management() const { return time[WHITE] || time[BLACK]; }
+
+    TimePoint time[COLOR_NB], inc[COLOR_NB], movetime, startTime;
+    int       depth;
+    uint64_t  nodes;
+    bool      infinite, ponderMode;
+};
+
+// Called after every completed iteration with the result so far
+using IterationCallback = std::function<void(const SearchResult&)>;
+
+// Worker runs one iterative deepening search from a root position. It owns
+// the per-search state (clock, move ordering tables and statistics); the
+// limits, the stop flag and the transposition table are shared with the other
+// workers of the ThreadPool. Worker 0 is the main thread: it manages the time
+// and reports iterations, the others are helpers.
+class Worker {
+   public:
+    Worker(const LimitsType& limits, ThreadPool& threads, size_t idx)
+        : limits(limits), threads(threads), idx(idx) {}
+
+    SearchResult iterative_deepening(Position& pos, const IterationCallback& onIter);
+
+    bool     is_main() const { return idx == 0; }
+    uint64_t nodes_searched() const { return nodes.load(std::memory_order_relaxed); }
+    const SearchResult& result() const { return lastResult; }
+
+   private:
+    Value search_root(Position& pos, int depth, ExtMove* begin, ExtMove* end, Move& bestMove);
+    Value negamax(Position& pos, int depth, Value alpha, Value beta, int ply);
+    Value qsearch(Position& pos, Value alpha, Value beta, int ply, int depth = 0);
+    void  check_time();
+    bool  probe_bitbase(const Position& pos, Value& value, bool& tbWon);
+
+    void update_quiet_stats(Color us, Move bestMove, const Move* quiets, int quietCount, int depth,
+                            int ply);
+
+    const LimitsType& limits;
+    ThreadPool&       threads;
+    const size_t      idx;
+    TimeManagement    tm;
+    SearchResult      lastResult{};
+
+    // Move ordering state, valid for the whole iterative deepening search
+    ButterflyHistory mainHistory;
+    Move             killers[MAX_PLY][2];
+
+    // Read by the main thread while this worker searches
+    std::atomic<uint64_t> nodes{0};
+    uint64_t              ttProbes = 0, ttHits = 0, tbHits = 0;
+
+    // The side the bitbase says wins from the root, or COLOR_NB
+    Color tbWinner = COLOR_NB;
 };
 
+}  // namespace Search
+
+// Searches pos within the given limits with iterative deepening, on as many
+// threads as the ThreadPool is set to. The answer is always the result of the
+// deepest fully completed iteration. It returns when the search is over, so
+// infinite and ponder searches belong on a thread of their own (see Engine).
+SearchResult search(Position& pos, const Search::LimitsType& limits,
+                    const Search::IterationCallback& onIter = nullptr);
+
+// Fixed-depth search
 SearchResult search_best_move(Position& pos, int depth);
+
+// The reply to m stored in the TT, if it is legal, or Move::none()
+Move expected_reply(Position& pos, Move m);
+
+// Pondering with the opponent to move in pos: searches our answer to the
+// expected reply and to the `replies` most likely others, one ply deeper
+// every round, until stop or ponderhit. The first rounds rank all replies,
+// the likely ones being those that leave us worst off. Nothing is returned:
+// the answers are left in the TT, for the search after the reply played.
+// The caller resets the flags, with ponder set, first.
+void ponder_replies(Position& pos, Move expected, int replies);
 }  // namespace tiny
 
-#endif  // MINMAX_H_INCLUDED
\ No newline at end of file
+#endif  // MINMAX_H_INCLUDED
@@ -0,0 +1,206 @@
+#include "movepick.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace tiny {
+
+namespace {
+
+enum Stages {
+    // generate main search moves
+    MAIN_TT,
+    CAPTURE_INIT,
+    GOOD_CAPTURE,
+    CHECK_DROP_INIT,
+    CHECK_DROP,
+    REFUTATION,
+    QUIET_INIT,
+    QUIET,
+
+    // generate evasion moves
+    EVASION_TT,
+    EVASION_INIT,
+    EVASION,
+
+    // generate quiescence search moves
+    QSEARCH_TT,
+    QCAPTURE_INIT,
+    QCAPTURE,
+    QCHECK_DROP_INIT,
+    QCHECK_DROP
+};
+
+// Captured pieces change sides through the pockets, so the victim is worth
+// far more than the attacker we might lose in return
+constexpr int CaptureMultiplier = 8;
+
+// Keeps captures and checks of the evasion list ahead of the quiet ones
+constexpr int EvasionCaptureBonus = 1 << 20;
+
+}  // namespace
+
+// Constructor for the main search. The TT move is only used if it is
+// pseudo-legal in this position, which also guards against hash collisions.
+MovePicker::MovePicker(const Position& p, Move ttm, const ButterflyHistory* mh,
+                       const Move* killers)
+    : pos(p), mainHistory(mh), ttMove(ttm), refutations{killers[0], killers[1]} {
+    stage = (pos.checkers() ? EVASION_TT : MAIN_TT) + !(ttm && pos.pseudo_legal(ttm));
+}
+
+// Constructor for the quiescence search. Out of check the TT move is only
+// used if it is one of the moves this search tries.
+MovePicker::MovePicker(const Position& p, Move ttm, const ButterflyHistory* mh, bool checkDrops)
+    : pos(p), mainHistory(mh), ttMove(ttm), refutations{}, checkDrops(checkDrops) {
+    const bool tried = ttm && pos.pseudo_legal(ttm) &&
+                       (pos.checkers() || pos.capture(ttm) || ttm.type_of() == PROMOTION ||
+                        (checkDrops && ttm.type_of() == DROP &&
+                         (pos.check_squares(ttm.drop_piece()) & ttm.to_sq())));
+    stage = (pos.checkers() ? EVASION_TT : QSEARCH_TT) + !tried;
+}
+
+// Assigns a numerical value to each move in [cur, endMoves). Captures and
+// promotions are ordered by MVV-LVA, everything else by history.
+template <GenType Type>
+void MovePicker::score() {
+    const Color us = pos.side_to_move();
+
+    for (ExtMove* m = cur; m != endMoves; ++m) {
+        if (Type == CAPTURES || (Type == EVASIONS && pos.capture(*m))) {
+            PieceType victim   = type_of(pos.piece_on(m->to_sq()));
+            PieceType attacker = type_of(pos.moved_piece(*m));
+            m->value = CaptureMultiplier * type_value(victim) - type_value(attacker);
+            if (m->type_of() == PROMOTION) m->value += type_value(m->promotion_type()) - PawnValue;
+            if (Type == EVASIONS) m->value += EvasionCaptureBonus;
+        } else
+            m->value = mainHistory->get(us, *m);
+    }
+}
+
+// Moves the highest scored move in [begin, end) to begin and returns it.
+// A full sort is wasted work when the node gets a cut-off early.
+ExtMove* MovePicker::select_best(ExtMove* begin, ExtMove* end) {
+    std::swap(*begin, *std::max_element(begin, end));
+    return begin;
+}
+
+// Killers are only tried when they have not been emitted by an earlier stage
+bool MovePicker::is_refutation(Move m) const {
+    return m && m != ttMove && pos.pseudo_legal(m) && !pos.capture(m) &&
+           m.type_of() != PROMOTION &&
+           !(m.type_of() == DROP && (pos.check_squares(m.drop_piece()) & m.to_sq()));
+}
+
+// Returns the next pseudo-legal move to be searched, or Move::none() when
+// all moves have been emitted.
+Move MovePicker::next_move() {
+top:
+    switch (stage) {
+        case MAIN_TT:
+        case EVASION_TT:
+        case QSEARCH_TT:
+            ++stage;
+            return ttMove;
+
+        case CAPTURE_INIT:
+        case QCAPTURE_INIT:
+            cur      = moves;
+            endMoves = generate<CAPTURES>(pos, cur);
+            score<CAPTURES>();
+            ++stage;
+            goto top;
+
+        case GOOD_CAPTURE:
+            while (cur < endMoves)
+                if (Move m = *select_best(cur++, endMoves); m != ttMove)
+                    return m;
+            ++stage;
+            [[fallthrough]];
+
+        // Split the drops: the checking ones are tried now, the rest are sorted
+        // together with the quiet board moves.
+        case CHECK_DROP_INIT:
+            cur           = endMoves;
+            endMoves      = generate<DROPS>(pos, cur);
+            endCheckDrops = std::partition(cur, endMoves, [&](const ExtMove& m) {
+                return pos.check_squares(m.drop_piece()) & m.to_sq();
+            });
+            score<DROPS>();
+            ++stage;
+            [[fallthrough]];
+
+        case CHECK_DROP:
+            while (cur < endCheckDrops)
+                if (Move m = *select_best(cur++, endCheckDrops); m != ttMove)
+                    return m;
+            ++stage;
+            refCur = refutations;
+            [[fallthrough]];
+
+        case REFUTATION:
+            while (refCur < refutations + 2) {
+                Move m = *refCur++;
+                if (is_refutation(m) && (refCur == refutations + 1 || m != refutations[0]))
+                    return m;
+            }
+            ++stage;
+            [[fallthrough]];
+
+        case QUIET_INIT:
+            cur      = endCheckDrops;
+            endMoves = generate<QUIETS>(pos, endMoves);
+            score<QUIETS>();
+            ++stage;
+            [[fallthrough]];
+
+        case QUIET:
+            while (cur < endMoves)
+                if (Move m = *select_best(cur++, endMoves);
+                    m != ttMove && m != refutations[0] && m != refutations[1])
+                    return m;
+            return Move::none();
+
+        case EVASION_INIT:
+            cur      = moves;
+            endMoves = generate<EVASIONS>(pos, cur);
+            score<EVASIONS>();
+            ++stage;
+            [[fallthrough]];
+
+        case EVASION:
+            while (cur < endMoves)
+                if (Move m = *select_best(cur++, endMoves); m != ttMove)
+                    return m;
+            return Move::none();
+
+        case QCAPTURE:
+            while (cur < endMoves)
+                if (Move m = *select_best(cur++, endMoves); m != ttMove)
+                    return m;
+            if (!checkDrops) return Move::none();
+            ++stage;
+            [[fallthrough]];
+
+        case QCHECK_DROP_INIT:
+            cur           = moves;
+            endMoves      = generate<DROPS>(pos, cur);
+            endCheckDrops = std::partition(cur, endMoves, [&](const ExtMove& m) {
+                return pos.check_squares(m.drop_piece()) & m.to_sq();
+            });
+            endMoves      = endCheckDrops;
+            score<DROPS>();
+            ++stage;
+            [[fallthrough]];
+
+        case QCHECK_DROP:
+            while (cur < endMoves)
+                if (Move m = *select_best(cur++, endMoves); m != ttMove)
+                    return m;
+            return Move::none();
+    }
+
+    assert(false);
+    return Move::none();  // Silence warning
+}
+
+}  // namespace tiny
@@ -0,0 +1,82 @@
+// movepick.h
+#ifndef MOVEPICK_H_INCLUDED
+#define MOVEPICK_H_INCLUDED
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "../core/movegen.h"
+#include "../core/position.h"
+#include "../core/types.h"
+
+namespace tiny {
+
+// Board moves are indexed by from/to; drops get their own slots per piece
+// type, as from == to for them.
+constexpr int HISTORY_INDEX_NB = SQUARE_NB * SQUARE_NB + 4 * SQUARE_NB;
+
+inline int history_index(Move m) {
+    return m.type_of() == DROP ? SQUARE_NB * SQUARE_NB + (m.drop_piece() - PAWN) * SQUARE_NB + m.to_sq()
+                               : m.from_sq() * SQUARE_NB + m.to_sq();
+}
+
+// ButterflyHistory records how often quiet moves (board moves and drops) have
+// been successful or unsuccessful during the current search, and is used for
+// reduction and move ordering decisions. Entries saturate at +-HistoryMax.
+struct ButterflyHistory {
+    static constexpr int HistoryMax = 8192;
+
+    void clear() { std::memset(table, 0, sizeof(table)); }
+
+    int get(Color c, Move m) const { return table[c][history_index(m)]; }
+
+    // Bonuses shrink as the entry approaches the bound, so it never overflows
+    void update(Color c, Move m, int bonus) {
+        int16_t& entry = table[c][history_index(m)];
+        entry += int16_t(bonus - entry * std::abs(bonus) / HistoryMax);
+    }
+
+   private:
+    int16_t table[COLOR_NB][HISTORY_INDEX_NB];
+};
+
+// MovePicker class is used to pick one pseudo-legal move at a time from the
+// current position. The most important method is next_move(), which emits one
+// new pseudo-legal move on every call, until there are no moves left, when
+// Move::none() is returned. In order to improve the efficiency of the alpha-beta
+// algorithm, MovePicker attempts to return the moves which are most likely to
+// get a cut-off first: the TT move, captures by MVV-LVA, checking drops, the
+// killers and finally the history-ordered quiets. Each stage only generates its
+// own moves, so a cut-off skips the generation of the later ones. For the
+// quiescence search only the TT move, the captures and, if asked, the checking
+// drops are emitted.
+class MovePicker {
+   public:
+    MovePicker(const MovePicker&)            = delete;
+    MovePicker& operator=(const MovePicker&) = delete;
+    MovePicker(const Position&, Move ttm, const ButterflyHistory*, const Move* killers);
+    MovePicker(const Position&, Move ttm, const ButterflyHistory*, bool checkDrops);
+
+    Move next_move();
+
+   private:
+    template <GenType>
+    void     score();
+    ExtMove* select_best(ExtMove* begin, ExtMove* end);
+    bool     is_refutation(Move m) const;
+
+    const Position&         pos;
+    const ButterflyHistory* mainHistory;
+    Move                    ttMove;
+    Move                    refutations[2];
+    bool                    checkDrops = false;
+    const Move*             refCur;
+    ExtMove *               cur, *endMoves, *endCheckDrops;
+    int                     stage;
+    ExtMove                 moves[MAX_MOVES];
+};
+
+}  // namespace tiny
+
+#endif  // #ifndef MOVEPICK_H_INCLUDED
@@ -0,0 +1,120 @@
+#include "thread.h"
+
+#include <thread>
+
+#include "tt.h"
+
+namespace tiny {
+
+ThreadPool Threads;  // Global object
+
+// Searches pos on threadCount threads and returns the result of the worker
+// that completed the deepest iteration, the main worker winning ties. Node,
+// TT and bitbase statistics are summed over all workers.
+SearchResult ThreadPool::start_thinking(Position& pos, const Search::LimitsType& limits,
+                                        const Search::IterationCallback& onIter) {
+    workers.clear();
+    for (size_t i = 0; i < threadCount; ++i)
+        workers.push_back(std::make_unique<Search::Worker>(limits, *this, i));
+
+    // Helpers make their moves on their own copy. The StateInfo chain below
+    // the root is shared, but only read, for repetition detection.
+    std::vector<Position>    rootPositions(threadCount - 1, pos);
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < threadCount; ++i)
+        helpers.emplace_back([this, i, &rootPositions] {
+            workers[i]->iterative_deepening(rootPositions[i - 1], nullptr);
+        });
+
+    workers[0]->iterative_deepening(pos, onIter);
+
+    // Even out of depth, an infinite or ponder search waits to be told
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait(lock, [&] {
+            return stop || (!limits.infinite && !(limits.ponderMode && ponder));
+        });
+    }
+
+    // The main worker decides when the search is over
+    stop = true;
+    for (std::thread& th : helpers) th.join();
+
+    SearchResult best = workers[0]->result();
+    for (size_t i = 1; i < threadCount; ++i) {
+        const SearchResult& r = workers[i]->result();
+        if (r.depth > best.depth && r.bestMove) best = r;
+    }
+
+    best.nodes    = nodes_searched();
+    best.ttProbes = best.ttHits = best.tbHits = 0;
+    for (const auto& w : workers) {
+        best.ttProbes += w->result().ttProbes;
+        best.ttHits += w->result().ttHits;
+        best.tbHits += w->result().tbHits;
+    }
+    best.hashfull   = TT.hashfull();
+    best.time       = workers[0]->result().time;
+    best.ponderMove = expected_reply(pos, best.bestMove);
+
+    return best;
+}
+
+// Readies the flags for a new search. Called on the thread that may stop it
+// later, before the search starts, so that no early stop is lost.
+void ThreadPool::reset_flags(bool ponderMode) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop          = false;
+    ponder        = ponderMode;
+    stopRequested = speculating = false;
+}
+
+// Aborts the running search. The flag is set under the lock so that a
+// search about to wait for it cannot miss the wakeup.
+void ThreadPool::request_stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = stopRequested = true;
+    }
+    wakeup.notify_all();
+}
+
+// The opponent played the move we pondered on: from now on the search runs
+// on our clock, and may answer at once if it already ran out of depth. A
+// search of another reply is of no more use and is aborted.
+void ThreadPool::ponderhit() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ponder = false;
+        if (speculating) stop = true;
+    }
+    wakeup.notify_all();
+}
+
+void ThreadPool::begin_speculation() {
+    std::lock_guard<std::mutex> lock(mutex);
+    speculating = true;
+}
+
+// Each search sets stop when it ends, so it is cleared for the next one
+bool ThreadPool::resume_speculation() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopRequested || !ponder) return false;
+    stop = false;
+    return true;
+}
+
+void ThreadPool::end_speculation() {
+    std::lock_guard<std::mutex> lock(mutex);
+    speculating = false;
+    stop        = stopRequested;
+}
+
+// Returns the number of nodes searched by all workers so far
+uint64_t ThreadPool::nodes_searched() const {
+    uint64_t sum = 0;
+    for (const auto& w : workers) sum += w->nodes_searched();
+    return sum;
+}
+
+}  // namespace tiny
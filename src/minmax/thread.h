@@ -0,0 +1,61 @@
+// thread.h
+#ifndef THREAD_H_INCLUDED
+#define THREAD_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../core/position.h"
+#include "minmax.h"
+
+namespace tiny {
+
+// ThreadPool runs a Lazy SMP search: every thread searches the same root with
+// its own Search::Worker and Position copy, and they cooperate only through
+// the shared transposition table. The calling thread becomes the main worker,
+// the helpers are started for each search and joined when it ends.
+//
+// The caller calls reset_flags() before starting a search. In infinite or
+// ponder mode the search does not answer before request_stop() or
+// ponderhit(), which another thread calls while it runs.
+class ThreadPool {
+   public:
+    void   set(size_t requested) { threadCount = requested ? requested : 1; }
+    size_t size() const { return threadCount; }
+
+    SearchResult start_thinking(Position& pos, const Search::LimitsType& limits,
+                                const Search::IterationCallback& onIter);
+    uint64_t     nodes_searched() const;
+
+    void reset_flags(bool ponderMode);
+    void request_stop();
+    void ponderhit();
+
+    // The searches ponder_replies() runs one after another end at ponderhit
+    // as well as at stop. resume_speculation() readies the next one, unless
+    // either came; end_speculation() leaves stop set only for a real stop.
+    void begin_speculation();
+    bool resume_speculation();
+    void end_speculation();
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> ponder{false};  // the clock is not ours until ponderhit
+
+   private:
+    size_t                                       threadCount = 1;
+    std::mutex                                   mutex;
+    std::condition_variable                      wakeup;
+    bool stopRequested = false, speculating = false;  // guarded by mutex
+    std::vector<std::unique_ptr<Search::Worker>> workers;
+};
+
+extern ThreadPool Threads;
+
+}  // namespace tiny
+
+#endif  // #ifndef THREAD_H_INCLUDED
@@ -0,0 +1,43 @@
+#include "timeman.h"
+
+#include <algorithm>
+
+#include "minmax.h"
+
+namespace tiny {
+
+namespace {
+
+constexpr TimePoint MoveOverhead = 10;  // Time lost per move to I/O and the GUI, in ms
+constexpr int       MoveHorizon  = 20;  // Plan as if this many moves remain to be played
+constexpr int       MaxRatio     = 4;   // Hard limit as a multiple of the optimum
+
+}  // namespace
+
+// Called at the beginning of the search and calculates the bounds of time
+// allowed for the current game ply. Fixed 'movetime' uses the whole budget as
+// both optimum and maximum; with a clock we spread the remaining time (plus
+// the increments we expect to collect) over the next MoveHorizon moves and
+// never plan to use more than 80% of what is left on the clock.
+void TimeManagement::init(const Search::LimitsType& limits, Color us) {
+    startTime = limits.startTime;
+
+    if (limits.movetime) {
+        optimumTime = maximumTime = std::max(TimePoint(1), limits.movetime - MoveOverhead);
+        return;
+    }
+
+    if (!limits.use_time_management()) {
+        optimumTime = maximumTime = 0;
+        return;
+    }
+
+    TimePoint timeLeft = std::max(TimePoint(1), limits.time[us] + limits.inc[us] * (MoveHorizon - 1) -
+                                                    MoveOverhead * (2 + MoveHorizon));
+
+    maximumTime = std::max(TimePoint(1), limits.time[us] * 8 / 10 - MoveOverhead);
+    optimumTime = std::min(timeLeft / MoveHorizon, maximumTime);
+    maximumTime = std::min(optimumTime * MaxRatio, maximumTime);
+}
+
+}  // namespace tiny
@@ -0,0 +1,35 @@
+// timeman.h
+#ifndef TIMEMAN_H_INCLUDED
+#define TIMEMAN_H_INCLUDED
+
+#include "../core/misc.h"
+#include "../core/types.h"
+
+namespace tiny {
+
+namespace Search {
+struct LimitsType;
+}
+
+// The TimeManagement class computes the time to think from our remaining
+// time and increment, spread over MoveHorizon moves, less MoveOverhead per
+// move, with the hard limit at most MaxRatio times the optimum.
+// optimum() is the budget after which no new iteration is started, maximum()
+// the hard limit at which a running iteration is aborted.
+class TimeManagement {
+   public:
+    void init(const Search::LimitsType& limits, Color us);
+
+    TimePoint optimum() const { return optimumTime; }
+    TimePoint maximum() const { return maximumTime; }
+    TimePoint elapsed() const { return now() - startTime; }
+
+   private:
+    TimePoint startTime;
+    TimePoint optimumTime;
+    TimePoint maximumTime;
+};
+
+}  // namespace tiny
+
+#endif  // #ifndef TIMEMAN_H_INCLUDED
@@ -0,0 +1,123 @@
+#include "tt.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace tiny {
+
+TranspositionTable TT;  // Our global transposition table
+
+// Unpacks an entry. Depth and bound of an empty slot are meaningless.
+TTData TTEntry::unpack(const Packed& p) {
+    return TTData{Move(p.move16), Value(p.value16), int(p.depth8) + DEPTH_ENTRY_OFFSET,
+                  Bound(p.genBound8 & 0x3)};
+}
+
+// Populates the TTEntry with a new node's data, possibly
+// overwriting an old position. The entry is read and written back as a whole;
+// if another thread stores in between, one of the two writes is lost, which is
+// harmless for a hash table.
+void TTEntry::save(Key k, Value v, Bound b, int d, Move m, uint8_t generation8) {
+    Packed p = load();
+
+    // Preserve the old ttmove if we don't have a new one
+    if (m || uint16_t(k) != p.key16) p.move16 = m.raw();
+
+    // Overwrite less valuable entries (cheapest checks first)
+    if (b == BOUND_EXACT || uint16_t(k) != p.key16 || d - DEPTH_ENTRY_OFFSET + 2 > p.depth8) {
+        assert(d > DEPTH_ENTRY_OFFSET);
+        assert(d < 256 + DEPTH_ENTRY_OFFSET);
+
+        p.key16     = uint16_t(k);
+        p.depth8    = uint8_t(d - DEPTH_ENTRY_OFFSET);
+        p.genBound8 = uint8_t(generation8 | uint8_t(b));
+        p.value16   = int16_t(v);
+    }
+
+    store(p);
+}
+
+// Sets the size of the transposition table,
+// measured in megabytes. Transposition table consists
+// of clusters and each cluster consists of ClusterSize number of TTEntry.
+void TranspositionTable::resize(size_t mbSize) {
+    size_t newClusterCount = mbSize * 1024 * 1024 / sizeof(Cluster);
+    if (newClusterCount == clusterCount && table) return;
+
+    clusterCount = newClusterCount ? newClusterCount : 1;
+    table.reset(new (std::nothrow) Cluster[clusterCount]);
+
+    if (!table) {
+        std::cerr << "Failed to allocate " << mbSize << "MB for transposition table." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    clear();
+}
+
+// Wipes the whole TT and resets the generation.
+void TranspositionTable::clear() {
+    std::memset(static_cast<void*>(table.get()), 0, clusterCount * sizeof(Cluster));
+    generation8 = 0;
+}
+
+// Looks up the current position in the transposition
+// table. It returns true and a pointer to the TTEntry if the position is found,
+// with a snapshot of the entry in data. Otherwise, it returns false and a
+// pointer to an empty or least valuable TTEntry to be replaced later. The
+// replace value of an entry is calculated as its depth minus 8 times its
+// relative age. TTEntry t1 is considered more valuable than TTEntry t2 if its
+// replace value is greater than that of t2.
+TTEntry* TranspositionTable::probe(const Key key, bool& found, TTData& data) const {
+    TTEntry* const tte   = first_entry(key);
+    const uint16_t key16 = uint16_t(key);  // Use the low 16 bits as key inside the cluster
+
+    TTEntry::Packed e[ClusterSize];
+    for (int i = 0; i < ClusterSize; ++i) {
+        e[i] = tte[i].load();
+
+        if (e[i].key16 == key16 && e[i].depth8) {
+            // Refresh the entry so it is not aged out while still in use
+            e[i].genBound8 = uint8_t(generation8 | (e[i].genBound8 & (GENERATION_DELTA - 1)));
+            tte[i].store(e[i]);
+            data = TTEntry::unpack(e[i]);
+            return found = true, &tte[i];
+        }
+    }
+
+    // Find an entry to be replaced according to the replacement strategy
+    int replace = 0;
+    for (int i = 1; i < ClusterSize; ++i)
+        // Due to our packed storage format for generation and its cyclic
+        // nature we add GENERATION_CYCLE (256 is the modulus, plus what
+        // is needed to keep the unrelated lowest n bits from affecting
+        // the result) to calculate the entry age correctly even after
+        // generation8 overflows into the next cycle.
+        if (e[replace].depth8 -
+                ((GENERATION_CYCLE + generation8 - e[replace].genBound8) & GENERATION_MASK) >
+            e[i].depth8 - ((GENERATION_CYCLE + generation8 - e[i].genBound8) & GENERATION_MASK))
+            replace = i;
+
+    data = TTData{Move::none(), VALUE_NONE, DEPTH_ENTRY_OFFSET, BOUND_NONE};
+    return found = false, &tte[replace];
+}
+
+// Returns an approximation of the hashtable
+// occupation during a search. The hash is x permill full, as per UCI protocol.
+// Only counts entries which match the current generation.
+int TranspositionTable::hashfull() const {
+    const size_t sample = std::min<size_t>(1000, clusterCount);
+    int          cnt    = 0;
+
+    for (size_t i = 0; i < sample; ++i)
+        for (int j = 0; j < ClusterSize; ++j) {
+            const TTEntry::Packed p = table[i].entry[j].load();
+            cnt += p.depth8 && (p.genBound8 & GENERATION_MASK) == generation8;
+        }
+
+    return int(cnt * 1000 / (sample * ClusterSize));
+}
+
+}  // namespace tiny
@@ -0,0 +1,119 @@
+// tt.h
+#ifndef TT_H_INCLUDED
+#define TT_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "../core/misc.h"
+#include "../core/types.h"
+
+namespace tiny {
+
+// Depths are stored with an offset so that an empty slot (depth8 == 0) can be
+// told apart from a real entry, and so quiescence depths (<= 0) still fit.
+constexpr int DEPTH_ENTRY_OFFSET = -3;
+
+// TTData is a snapshot of one entry, taken with a single load
+struct TTData {
+    Move  move;
+    Value value;
+    int   depth;
+    Bound bound;
+};
+
+// TTEntry struct is the 8 bytes transposition table entry, defined as below:
+//
+// key        16 bit
+// move       16 bit
+// value      16 bit
+// depth       8 bit
+// generation  6 bit
+// bound type  2 bit
+//
+// The fields are packed into one 64 bit word which is only ever read and
+// written as a whole with relaxed atomics. Search threads share the table
+// without locks, and a racing write can replace an entry but never tear it.
+struct TTEntry {
+    TTData read() const { return unpack(load()); }
+    void   save(Key k, Value v, Bound b, int d, Move m, uint8_t generation8);
+
+   private:
+    friend class TranspositionTable;
+
+    struct Packed {
+        uint16_t key16;
+        uint16_t move16;
+        int16_t  value16;
+        uint8_t  depth8;
+        uint8_t  genBound8;
+    };
+
+    static TTData unpack(const Packed& p);
+
+    Packed load() const {
+        Packed   p;
+        uint64_t w = data.load(std::memory_order_relaxed);
+        std::memcpy(&p, &w, sizeof(p));
+        return p;
+    }
+
+    void store(const Packed& p) {
+        uint64_t w;
+        std::memcpy(&w, &p, sizeof(w));
+        data.store(w, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> data;
+};
+
+static_assert(sizeof(TTEntry) == 8, "TTEntry must be 8 bytes");
+
+// A TranspositionTable is an array of Cluster, of size clusterCount. Each
+// cluster is exactly one cache line holding ClusterSize entries, so a probe
+// touches a single line. Each non-empty entry contains information on exactly
+// one position. Replacement favours deep entries from the current search over
+// shallow or stale ones.
+class TranspositionTable {
+    static constexpr int ClusterSize = 8;
+
+    struct alignas(64) Cluster {
+        TTEntry entry[ClusterSize];
+    };
+
+    static_assert(sizeof(Cluster) == 64, "Cluster must be one cache line");
+
+    // The low 2 bits of genBound8 hold the bound, the rest the generation
+    static constexpr unsigned GENERATION_BITS  = 2;
+    static constexpr int      GENERATION_DELTA = (1 << GENERATION_BITS);
+    static constexpr int      GENERATION_CYCLE = 255 + GENERATION_DELTA;
+    static constexpr int      GENERATION_MASK  = (0xFF << GENERATION_BITS) & 0xFF;
+
+   public:
+    void new_search() { generation8 += GENERATION_DELTA; }  // Lower bits are used for other things
+    TTEntry* probe(const Key key, bool& found, TTData& data) const;
+    int      hashfull() const;
+    void     resize(size_t mbSize);
+    void     clear();
+    size_t   size_mb() const { return clusterCount * sizeof(Cluster) / (1024 * 1024); }
+
+    TTEntry* first_entry(const Key key) const {
+        return &table[mul_hi64(key, clusterCount)].entry[0];
+    }
+
+    uint8_t generation() const { return generation8; }
+
+   private:
+    size_t                     clusterCount = 0;
+    std::unique_ptr<Cluster[]> table;
+    uint8_t                    generation8 = 0;  // Size must be not bigger than TTEntry::genBound8
+};
+
+extern TranspositionTable TT;
+
+}  // namespace tiny
+
+#endif  // #ifndef TT_H_INCLUDED
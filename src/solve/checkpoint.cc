@@ -0,0 +1,151 @@
+#include "checkpoint.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+namespace tiny::retro
+{
+
+    namespace
+    {
+        constexpr char StateMagic[8] = {'T', 'N', 'Y', 'C', 'K', 'P', 'T', 1};
+
+        struct StateFile
+        {
+            char magic[8];
+            Checkpoint::State state;
+        };
+
+        // fseek() takes a long, which is 32 bits on Windows
+        bool seek(FILE *f, uint64_t offset)
+        {
+#ifdef _WIN32
+            return _fseeki64(f, int64_t(offset), SEEK_SET) == 0;
+#else
+            return ::fseeko(f, off_t(offset), SEEK_SET) == 0;
+#endif
+        }
+
+        // Flushes f through to the disk, not just to the system
+        bool sync(FILE *f)
+        {
+            if (std::fflush(f) != 0)
+                return false;
+#ifdef _WIN32
+            return _commit(_fileno(f)) == 0;
+#else
+            return ::fsync(fileno(f)) == 0;
+#endif
+        }
+
+        // Writes all of data at offset and flushes it to disk. A whole file
+        // drops anything left over from an earlier attempt.
+        bool write_file(const std::string &path, uint64_t offset, const std::vector<char> &data,
+                        bool whole)
+        {
+            FILE *f = whole ? nullptr : std::fopen(path.c_str(), "r+b");
+            if (!f)
+                f = std::fopen(path.c_str(), "wb");
+            if (!f)
+                return false;
+
+            bool ok = seek(f, offset) &&
+                      std::fwrite(data.data(), 1, data.size(), f) == data.size() && sync(f);
+            return std::fclose(f) == 0 && ok;
+        }
+    } // namespace
+
+    Checkpoint::Checkpoint(const std::string &dir) : dir(dir)
+    {
+        std::error_code ec;
+        std::filesystem::create_directory(dir, ec);
+    }
+
+    std::string Checkpoint::whole(const std::string &name, uint64_t gen) const
+    {
+        return dir + "/" + name + "." + std::to_string(gen);
+    }
+
+    bool Checkpoint::read(const std::string &path, uint64_t offset, void *data, size_t bytes) const
+    {
+        FILE *f = std::fopen(path.c_str(), "rb");
+        if (!f)
+            return bytes == 0;
+
+        bool ok = seek(f, offset) && std::fread(data, 1, bytes, f) == bytes;
+        std::fclose(f);
+        return ok;
+    }
+
+    bool Checkpoint::load(State &state)
+    {
+        StateFile f;
+        if (!read(dir + "/state", 0, &f, sizeof(f)) ||
+            std::memcmp(f.magic, StateMagic, sizeof(f.magic)) != 0)
+            return false;
+
+        loaded = state = f.state;
+        generation = state.generation;
+        return true;
+    }
+
+    void Checkpoint::save(Snapshot &&s)
+    {
+        wait();
+        s.state.generation = ++generation;
+        writer = std::thread([this, s = std::move(s)] { write(s); });
+    }
+
+    void Checkpoint::wait()
+    {
+        if (writer.joinable())
+            writer.join();
+    }
+
+    // The growing arrays are only written past the valid length of the last
+    // snapshot, and whole arrays under a new name, so the last snapshot is
+    // still good until the new state replaces it.
+    void Checkpoint::write(const Snapshot &s)
+    {
+        bool ok = true;
+        for (const auto &[name, update] : s.updates)
+            ok = ok && write_file(dir + "/" + name, update.first, update.second, false);
+        for (const auto &[name, data] : s.files)
+            ok = ok && write_file(whole(name, s.state.generation), 0, data, true);
+
+        StateFile f;
+        std::memcpy(f.magic, StateMagic, sizeof(f.magic));
+        f.state = s.state;
+        std::vector<char> bytes(reinterpret_cast<const char *>(&f),
+                                reinterpret_cast<const char *>(&f) + sizeof(f));
+
+        // std::rename() does not replace an existing file on Windows
+        const std::string tmp = dir + "/state.tmp";
+        std::error_code ec;
+        if (!ok || !write_file(tmp, 0, bytes, true))
+            ec = std::error_code(errno, std::generic_category());
+        else
+            std::filesystem::rename(tmp, dir + "/state", ec);
+        if (!ok || ec)
+        {
+            std::cerr << "[solve] warning: checkpoint to " << dir << " failed: " << ec.message()
+                      << "\n";
+            return;
+        }
+
+        // The files of the previous generation are no longer needed
+        for (const auto &[name, data] : s.files)
+            std::remove(whole(name, s.state.generation - 1).c_str());
+    }
+
+} // namespace tiny::retro
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tiny::retro
+{
+
+    // Checkpoint keeps snapshots of a solve in a directory, so that an
+    // interrupted solve can go on from the last one.
+    //
+    // A snapshot has two kinds of files. Growing arrays are written in place,
+    // only the part changed since the previous snapshot, and the state says
+    // how much of them is valid. Other arrays are written whole, under a new
+    // generation number each time. The state file is written last and renamed
+    // over the previous one, so a crash at any point leaves the previous
+    // snapshot intact.
+    //
+    // Snapshots are copied out of the solver and written by a background
+    // thread: the solver only waits if the previous one is still being written.
+    class Checkpoint
+    {
+    public:
+        struct State
+        {
+            uint64_t startKey = 0;   // node key of the solved position
+            uint32_t phase = 0;      // 0 if there is no snapshot
+            uint32_t layers = 0;     // Phase B: layers propagated
+            uint64_t expanded = 0;   // Phase A: nodes expanded
+            uint64_t nodes = 0;      // nodes found
+            uint64_t solved = 0;     // Phase B: nodes solved by propagation
+            uint64_t frontier = 0;   // Phase B: nodes in the next layer
+            uint64_t generation = 0; // of the files written whole
+        };
+
+        struct Snapshot
+        {
+            State state;
+            std::vector<std::pair<std::string, std::pair<uint64_t, std::vector<char>>>> updates;
+            std::vector<std::pair<std::string, std::vector<char>>> files;
+
+            // Writes n elements at element `first` of a growing array
+            template <typename T>
+            void update(const std::string &name, uint64_t first, const T *data, size_t n)
+            {
+                const char *p = reinterpret_cast<const char *>(data);
+                std::vector<char> bytes(p, p + n * sizeof(T));
+                updates.push_back({name, {first * sizeof(T), std::move(bytes)}});
+            }
+
+            // Writes a whole array
+            template <typename T>
+            void write(const std::string &name, const T *data, size_t n)
+            {
+                const char *p = reinterpret_cast<const char *>(data);
+                files.push_back({name, std::vector<char>(p, p + n * sizeof(T))});
+            }
+        };
+
+        // Snapshots go to dir, which is created if needed
+        explicit Checkpoint(const std::string &dir);
+        ~Checkpoint() { wait(); }
+        Checkpoint(const Checkpoint &) = delete;
+        Checkpoint &operator=(const Checkpoint &) = delete;
+
+        // Reads the state of the last snapshot. Returns false if there is none.
+        bool load(State &state);
+
+        // Reads n elements from element `first` of a growing array, or from
+        // a whole array of the loaded snapshot. Return false on a short read.
+        template <typename T>
+        bool read_update(const std::string &name, uint64_t first, T *data, size_t n) const
+        {
+            return read(dir + "/" + name, first * sizeof(T), data, n * sizeof(T));
+        }
+
+        template <typename T>
+        bool read_file(const std::string &name, T *data, size_t n) const
+        {
+            return read(whole(name, loaded.generation), 0, data, n * sizeof(T));
+        }
+
+        // Starts writing s in the background, after the previous snapshot
+        void save(Snapshot &&s);
+
+        // Waits until the last snapshot is on disk
+        void wait();
+
+    private:
+        std::string whole(const std::string &name, uint64_t generation) const;
+        bool read(const std::string &path, uint64_t offset, void *data, size_t bytes) const;
+        void write(const Snapshot &s);
+
+        std::string dir;
+        State loaded;
+        uint64_t generation = 0;
+        std::thread writer;
+    };
+
+} // namespace tiny::retro
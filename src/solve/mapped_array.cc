@@ -0,0 +1,147 @@
+#include "mapped_array.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace tiny::retro
+{
+
+    namespace
+    {
+        constexpr size_t PageSize = 4096;
+
+        size_t page_align(size_t bytes) { return (bytes + PageSize - 1) & ~(PageSize - 1); }
+
+        [[noreturn]] void fail(const char *what, size_t bytes)
+        {
+#ifdef _WIN32
+            const std::string why = "error " + std::to_string(GetLastError());
+#else
+            const std::string why = std::strerror(errno);
+#endif
+            std::cerr << "[solve] error: " << what << " " << bytes
+                      << " bytes for node data: " << why << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    } // namespace
+
+    MappedRegion::MappedRegion(const std::string &path)
+    {
+        if (path.empty())
+            return;
+
+        fileBacked = true;
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            fail("cannot create scratch file for", 0);
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+            fail("cannot create scratch file for", 0);
+
+        // Only the descriptor keeps the file alive from now on
+        ::unlink(path.c_str());
+#endif
+    }
+
+    MappedRegion::~MappedRegion()
+    {
+        if (!fileBacked)
+            return;
+#ifdef _WIN32
+        if (base)
+            UnmapViewOfFile(base);
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        if (base)
+            ::munmap(base, length);
+        ::close(fd);
+#endif
+    }
+
+    void MappedRegion::reserve(size_t bytes)
+    {
+        if (!fileBacked)
+        {
+            if (bytes <= length)
+                return;
+
+            // The vector copies the contents over when it grows
+            heap.resize((bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+            base = heap.data();
+            length = heap.size() * sizeof(std::max_align_t);
+            return;
+        }
+
+        bytes = page_align(bytes);
+        if (bytes <= length)
+            return;
+
+        // The file holds the contents, so the old mapping can just go
+#ifdef _WIN32
+        if (base)
+            UnmapViewOfFile(base);
+        if (mapping)
+            CloseHandle(mapping);
+        base = nullptr;
+
+        // A mapping larger than the file extends it
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, DWORD(uint64_t(bytes) >> 32),
+                                     DWORD(bytes), nullptr);
+        void *p = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes) : nullptr;
+        if (!p)
+            fail("cannot map", bytes);
+#else
+        if (::ftruncate(fd, off_t(bytes)) != 0)
+            fail("cannot extend scratch file to", bytes);
+
+        if (base)
+            ::munmap(base, length);
+        void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+            fail("cannot map", bytes);
+#endif
+
+        base = p;
+        length = bytes;
+    }
+
+    void MappedRegion::release(size_t from, size_t to)
+    {
+        // Only whole pages inside the range can go
+        from = page_align(from);
+        to = std::min(to, length) & ~(PageSize - 1);
+        if (!fileBacked || from >= to)
+            return;
+
+        char *p = static_cast<char *>(base) + from;
+#ifdef _WIN32
+        // Unlocking pages that are not locked takes them out of the working set
+        FlushViewOfFile(p, to - from);
+        VirtualUnlock(p, to - from);
+#else
+        ::msync(p, to - from, MS_SYNC);
+        ::madvise(p, to - from, MADV_DONTNEED);
+#endif
+    }
+
+} // namespace tiny::retro
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace tiny::retro
+{
+
+    // MappedRegion is a block of memory that can grow, held either in a
+    // std::vector or mapped from a scratch file. A file mapping lets the
+    // system write pages back to disk and drop them under memory pressure,
+    // so the block may be larger than physical memory. The scratch file is
+    // deleted as soon as nothing refers to it: unlinked right after it is
+    // created on POSIX, opened with FILE_FLAG_DELETE_ON_CLOSE on Windows.
+    class MappedRegion
+    {
+    public:
+        // An empty path keeps the block in memory, else in a file created at path
+        explicit MappedRegion(const std::string &path = {});
+        ~MappedRegion();
+        MappedRegion(const MappedRegion &) = delete;
+        MappedRegion &operator=(const MappedRegion &) = delete;
+
+        // Grows the region to at least `bytes`, keeping its contents. The
+        // base address may change.
+        void reserve(size_t bytes);
+
+        // Writes back the pages in [from, to) and drops them from memory.
+        // Does nothing for a block in memory, which has nowhere to go.
+        void release(size_t from, size_t to);
+
+        void *data() const { return base; }
+        size_t capacity() const { return length; }
+        bool file_backed() const { return fileBacked; }
+
+    private:
+        std::vector<std::max_align_t> heap; // the block, without a file
+        bool fileBacked = false;
+#ifdef _WIN32
+        void *file = nullptr, *mapping = nullptr; // HANDLEs
+#else
+        int fd = -1;
+#endif
+        void *base = nullptr;
+        size_t length = 0;
+    };
+
+    // MappedArray is a minimal std::vector over a MappedRegion. Elements are
+    // moved bytewise when the region grows and are never destroyed.
+    template <typename T>
+    class MappedArray
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "elements are never destroyed");
+
+    public:
+        explicit MappedArray(const std::string &path = {}) : region(path) {}
+
+        void reserve(size_t n)
+        {
+            if (n > capacity())
+                region.reserve(n * sizeof(T));
+        }
+
+        // New elements are value initialized
+        void resize(size_t n)
+        {
+            if (n > capacity())
+                reserve(std::max(n, 2 * capacity()));
+            for (size_t i = count; i < n; ++i)
+                new (data() + i) T();
+            count = n;
+        }
+
+        void push_back(const T &v)
+        {
+            resize(count + 1);
+            data()[count - 1] = v;
+        }
+
+        void clear() { count = 0; }
+
+        // Drops elements [from, to) from memory until they are next touched
+        void release(size_t from, size_t to) { region.release(from * sizeof(T), to * sizeof(T)); }
+
+        T *data() const { return static_cast<T *>(region.data()); }
+        T &operator[](size_t i) { return data()[i]; }
+        const T &operator[](size_t i) const { return data()[i]; }
+        T *begin() const { return data(); }
+        T *end() const { return data() + count; }
+
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+        size_t capacity() const { return region.capacity() / sizeof(T); }
+        bool file_backed() const { return region.file_backed(); }
+
+    private:
+        MappedRegion region;
+        size_t count = 0;
+    };
+
+} // namespace tiny::retro
@@ -0,0 +1,234 @@
+#include "position_index.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace tiny::retro
+{
+
+    namespace
+    {
+        // Grow when the table is 7/8 full. Robin hood probing keeps the probe
+        // lengths short even at this load.
+        constexpr size_t MaxLoadNum = 7, MaxLoadDen = 8;
+
+        // Old slots moved per insert while a migration is pending. The old
+        // table is at most 7/8 full, so this finishes it long before the new
+        // one (twice as large) needs to grow again.
+        constexpr size_t MigrateStep = 8;
+
+        constexpr size_t MinCapacity = 1024;
+    } // namespace
+
+    void PositionIndex::Table::allocate(size_t capacity)
+    {
+        keys.reset(new Key[capacity]);
+        ids.reset(new uint32_t[capacity]);
+        std::fill(ids.get(), ids.get() + capacity, NONE);
+        mask = capacity - 1;
+        shift = 64;
+        while (capacity >>= 1)
+            --shift;
+    }
+
+    // Fibonacci hashing: the top bits of the product are well mixed even if
+    // the keys are not random, such as packed or enumerated positions.
+    size_t PositionIndex::Table::home(Key k) const
+    {
+        return shift == 64 ? 0 : size_t((k * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+
+    uint32_t PositionIndex::Table::find(Key k) const
+    {
+        if (!ids)
+            return NONE;
+
+        for (size_t i = home(k), d = 0;; i = (i + 1) & mask, ++d)
+        {
+            if (ids[i] == NONE)
+                return NONE;
+            if (keys[i] == k)
+                return ids[i];
+            // A richer resident: k would have displaced it, so k is absent
+            if (distance(i) < d)
+                return NONE;
+        }
+    }
+
+    // Robin hood insertion: take the slot of any resident closer to its home
+    // than we are to ours, and carry on inserting the displaced entry.
+    void PositionIndex::Table::place(Key k, uint32_t id)
+    {
+        for (size_t i = home(k), d = 0;; i = (i + 1) & mask, ++d)
+        {
+            if (ids[i] == NONE)
+            {
+                keys[i] = k;
+                ids[i] = id;
+                return;
+            }
+
+            size_t rd = distance(i);
+            if (rd < d)
+            {
+                std::swap(k, keys[i]);
+                std::swap(id, ids[i]);
+                d = rd;
+            }
+        }
+    }
+
+    PositionIndex::PositionIndex(size_t expected)
+    {
+        size_t capacity = MinCapacity;
+        while (capacity * MaxLoadNum / MaxLoadDen < expected)
+            capacity *= 2;
+
+        cur.allocate(capacity);
+    }
+
+    uint32_t PositionIndex::find(Key k) const
+    {
+        uint32_t id = cur.find(k);
+        return id != NONE ? id : old.find(k);
+    }
+
+    uint32_t PositionIndex::insert(Key k, uint32_t id, bool &inserted)
+    {
+        if (old.ids)
+            migrate(MigrateStep);
+
+        uint32_t found = find(k);
+        if ((inserted = (found == NONE)))
+        {
+            if ((count + 1) * MaxLoadDen > cur.capacity() * MaxLoadNum)
+                grow();
+
+            ++count;
+            cur.place(k, id);
+            return id;
+        }
+        return found;
+    }
+
+    // Starts a migration into a table twice as large. A previous migration
+    // that is still pending is completed first.
+    void PositionIndex::grow()
+    {
+        if (old.ids)
+            migrate(old.capacity());
+
+        old = std::move(cur);
+        cur.allocate(2 * old.capacity());
+        migrated = 0;
+    }
+
+    // Moves the next `slots` slots of the old table into the live one and frees
+    // the old table once all of them are done. The old table itself is left
+    // untouched, so its pending part can still be probed.
+    void PositionIndex::migrate(size_t slots)
+    {
+        size_t end = std::min(migrated + slots, old.capacity());
+
+        for (; migrated < end; ++migrated)
+            if (old.ids[migrated] != NONE)
+                cur.place(old.keys[migrated], old.ids[migrated]);
+
+        if (migrated == old.capacity())
+        {
+            old = Table();
+            migrated = 0;
+        }
+    }
+
+    PositionIndex::Stats PositionIndex::stats() const
+    {
+        Stats s{count, capacity(), 0, 0.0, 0};
+        s.bytes = bytes();
+
+        size_t probes = 0;
+        auto scan = [&](const Table &t, size_t from)
+        {
+            for (size_t i = from; i < t.capacity(); ++i)
+                if (t.ids[i] != NONE)
+                {
+                    size_t len = t.distance(i) + 1;
+                    probes += len;
+                    s.maxProbe = std::max(s.maxProbe, len);
+                }
+        };
+        scan(cur, 0);
+        scan(old, migrated);
+
+        s.avgProbe = count ? double(probes) / count : 0.0;
+        return s;
+    }
+
+    ShardedPositionIndex::ShardedPositionIndex(size_t expected) : shards(new Shard[ShardCount])
+    {
+        for (size_t i = 0; i < ShardCount; ++i)
+            shards[i].index = PositionIndex(expected / ShardCount);
+    }
+
+    // The id is taken from the counter under the shard lock, so a key that
+    // two threads insert at once still gets a single id
+    uint32_t ShardedPositionIndex::insert(Key k, bool &inserted)
+    {
+        Shard &s = shards[shard_of(k)];
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        uint32_t id = s.index.find(k);
+        if ((inserted = (id == NONE)))
+            s.index.insert(k, id = next.fetch_add(1, std::memory_order_relaxed), inserted);
+        return id;
+    }
+
+    void ShardedPositionIndex::restore(Key k, uint32_t id)
+    {
+        {
+            Shard &s = shards[shard_of(k)];
+            std::lock_guard<std::mutex> lock(s.mutex);
+            bool inserted;
+            s.index.insert(k, id, inserted);
+        }
+
+        uint32_t n = next.load(std::memory_order_relaxed);
+        while (n <= id && !next.compare_exchange_weak(n, id + 1, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    size_t ShardedPositionIndex::capacity() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < ShardCount; ++i)
+            total += shards[i].index.capacity();
+        return total;
+    }
+
+    size_t ShardedPositionIndex::bytes() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < ShardCount; ++i)
+            total += shards[i].index.bytes();
+        return total;
+    }
+
+    PositionIndex::Stats ShardedPositionIndex::stats() const
+    {
+        PositionIndex::Stats total{0, 0, 0, 0.0, 0};
+
+        for (size_t i = 0; i < ShardCount; ++i)
+        {
+            PositionIndex::Stats s = shards[i].index.stats();
+            total.size += s.size;
+            total.capacity += s.capacity;
+            total.bytes += s.bytes;
+            total.avgProbe += s.avgProbe * s.size;
+            total.maxProbe = std::max(total.maxProbe, s.maxProbe);
+        }
+        total.avgProbe = total.size ? total.avgProbe / total.size : 0.0;
+        return total;
+    }
+
+} // namespace tiny::retro
@@ -0,0 +1,137 @@
+#pragma once
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "../core/types.h"
+
+namespace tiny::retro
+{
+
+    // PositionIndex maps position keys to dense node ids 0, 1, 2, ... It is an
+    // open addressing table with robin hood probing: keys and ids are stored
+    // inline in two flat arrays (12 bytes per slot), so there is no per-node
+    // heap allocation and a lookup touches one or two cache lines.
+    //
+    // Growing does not rehash everything at once. The old table is kept and its
+    // slots are migrated a few at a time by the following inserts; until the
+    // migration is done, lookups fall back to the old table.
+    class PositionIndex
+    {
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        struct Stats
+        {
+            size_t size;        // keys stored
+            size_t capacity;    // slots in the live table(s)
+            size_t bytes;       // memory held by the slot arrays
+            double avgProbe;    // mean slots inspected by a successful lookup
+            size_t maxProbe;    // worst case of the above
+        };
+
+        // Preallocates for about `expected` keys without growing
+        explicit PositionIndex(size_t expected = 0);
+
+        // Returns the id of k. A new key gets id size() and sets inserted.
+        uint32_t insert(Key k, bool &inserted) { return insert(k, uint32_t(count), inserted); }
+
+        // As above, but a new key gets the given id
+        uint32_t insert(Key k, uint32_t id, bool &inserted);
+
+        // Returns the id of k, or NONE if k is not in the index
+        uint32_t find(Key k) const;
+
+        size_t size() const { return count; }
+        size_t capacity() const { return cur.capacity() + old.capacity(); }
+        size_t bytes() const { return capacity() * SlotBytes; }
+        Stats stats() const;
+
+        // Calls f(key, id) for every key, in no particular order
+        template <typename F>
+        void for_each(F &&f) const
+        {
+            for (size_t i = 0; i <= cur.mask; ++i)
+                if (cur.ids[i] != NONE)
+                    f(cur.keys[i], cur.ids[i]);
+
+            for (size_t i = migrated; old.ids && i <= old.mask; ++i)
+                if (old.ids[i] != NONE)
+                    f(old.keys[i], old.ids[i]);
+        }
+
+    private:
+        static constexpr size_t SlotBytes = sizeof(Key) + sizeof(uint32_t);
+
+        struct Table
+        {
+            std::unique_ptr<Key[]> keys;
+            std::unique_ptr<uint32_t[]> ids;
+            size_t mask = 0;
+            int shift = 64;
+
+            void allocate(size_t capacity);
+            size_t capacity() const { return ids ? mask + 1 : 0; }
+            size_t home(Key k) const;
+            size_t distance(size_t i) const { return (i - home(keys[i])) & mask; }
+            uint32_t find(Key k) const;
+            void place(Key k, uint32_t id);
+        };
+
+        void grow();
+        void migrate(size_t slots);
+
+        Table cur, old;
+        size_t migrated = 0; // old slots below this are already in cur
+        size_t count = 0;
+    };
+
+    // ShardedPositionIndex spreads the keys over PositionIndex shards, each
+    // with its own lock, so that threads inserting at the same time seldom
+    // wait for each other. Ids come from one shared counter and stay dense.
+    class ShardedPositionIndex
+    {
+    public:
+        static constexpr uint32_t NONE = PositionIndex::NONE;
+
+        explicit ShardedPositionIndex(size_t expected = 0);
+
+        // Thread safe version of PositionIndex::insert()
+        uint32_t insert(Key k, bool &inserted);
+
+        // Adds k with a known id, to rebuild a saved index; thread safe
+        void restore(Key k, uint32_t id);
+
+        // Not safe while another thread inserts
+        uint32_t find(Key k) const { return shards[shard_of(k)].index.find(k); }
+
+        size_t size() const { return next.load(std::memory_order_relaxed); }
+        size_t capacity() const;
+        size_t bytes() const;
+        PositionIndex::Stats stats() const;
+
+        template <typename F>
+        void for_each(F &&f) const
+        {
+            for (size_t i = 0; i < ShardCount; ++i)
+                shards[i].index.for_each(f);
+        }
+
+    private:
+        static constexpr size_t ShardCount = 64;
+
+        struct Shard
+        {
+            std::mutex mutex;
+            PositionIndex index;
+        };
+
+        static size_t shard_of(Key k) { return size_t(k & (ShardCount - 1)); }
+
+        std::unique_ptr<Shard[]> shards;
+        std::atomic<uint32_t> next{0};
+    };
+
+} // namespace tiny::retro
@@ -0,0 +1,282 @@
+#include "position_indexer.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../core/bitboard.h"
+
+namespace tiny::retro
+{
+
+    namespace
+    {
+        constexpr auto Binomial = []
+        {
+            std::array<std::array<uint64_t, SQUARE_NB + 1>, SQUARE_NB + 1> c{};
+            for (int n = 0; n <= SQUARE_NB; ++n)
+            {
+                c[n][0] = 1;
+                for (int k = 1; k <= n; ++k)
+                    c[n][k] = c[n - 1][k - 1] + c[n - 1][k];
+            }
+            return c;
+        }();
+
+        constexpr uint64_t KingPairs = SQUARE_NB * (SQUARE_NB - 1);
+
+        // Calls f(counts) for every way of putting n pieces into the slots
+        template <typename Counts, typename F>
+        void for_each_split(Counts &counts, size_t slot, size_t slots, int n, F &&f)
+        {
+            if (slot + 1 == slots)
+            {
+                counts[slot] = uint8_t(n);
+                f(counts);
+                return;
+            }
+            for (int c = n; c >= 0; --c)
+            {
+                counts[slot] = uint8_t(c);
+                for_each_split(counts, slot + 1, slots, n - c, f);
+            }
+        }
+
+        // Returns the square of the p-th (from 0) set bit of b
+        Square nth_square(Bitboard b, int p)
+        {
+            while (p--)
+                pop_lsb(b);
+            return lsb(b);
+        }
+    } // namespace
+
+    PositionIndexer::PositionIndexer(const Position &pos)
+    {
+        std::array<int, 4> n = material(pos);
+
+        for (PieceType pt = PAWN; pt <= WAZIR; ++pt)
+        {
+            Group &g = groups[pt - PAWN];
+            g.n = n[pt - PAWN];
+            assert(g.n <= 2); // Pockets hold at most two pieces of a type
+
+            for (Color c : {WHITE, BLACK})
+                g.slots.push_back({make_piece(c, pt), false, false});
+
+            if (pt == PAWN)
+                for (Color c : {WHITE, BLACK})
+                    for (PieceType promo : {HORSE, FERZ, WAZIR})
+                        g.slots.push_back({make_piece(c, promo), true, false});
+
+            for (Color c : {WHITE, BLACK})
+                g.slots.push_back({make_piece(c, pt), false, true});
+
+            size_t codes = 1;
+            for (size_t i = 0; i < g.slots.size(); ++i)
+                codes *= g.n + 1;
+            g.splitId.assign(codes, UINT32_MAX);
+
+            std::array<uint8_t, MaxSlots> counts{};
+            for_each_split(counts, 0, g.slots.size(), g.n,
+                           [&](const std::array<uint8_t, MaxSlots> &split)
+                           {
+                               size_t code = 0;
+                               for (size_t i = g.slots.size(); i-- > 0;)
+                                   code = code * (g.n + 1) + split[i];
+                               g.splitId[code] = uint32_t(g.splits.size());
+                               g.splits.push_back(split);
+                           });
+        }
+
+        // Each combination of splits gets a contiguous range of indices, as
+        // large as the number of ways to place its board pieces
+        size_t combinations = 1;
+        for (const Group &g : groups)
+            combinations *= g.splits.size();
+
+        offset.resize(combinations + 1);
+        for (size_t id = 0; id < combinations; ++id)
+        {
+            uint64_t placements = 1;
+            int freeSquares = SQUARE_NB - 2;
+
+            for (size_t gi = groups.size(), rest = id; gi-- > 0; rest /= groups[gi].splits.size())
+            {
+                const Group &g = groups[gi];
+                const auto &split = g.splits[rest % g.splits.size()];
+                for (size_t i = 0; i < g.slots.size(); ++i)
+                    if (!g.slots[i].pocket)
+                    {
+                        // Zero once the pieces do not fit on the board
+                        placements *= freeSquares >= 0 ? Binomial[freeSquares][split[i]] : 0;
+                        freeSquares -= split[i];
+                    }
+            }
+            offset[id + 1] = offset[id] + placements;
+        }
+
+        perKings = offset.back();
+        total = COLOR_NB * KingPairs * perKings;
+    }
+
+    std::array<int, 4> PositionIndexer::material(const Position &pos)
+    {
+        std::array<int, 4> n{};
+
+        for (PieceType pt = PAWN; pt <= WAZIR; ++pt)
+        {
+            n[pt - PAWN] += popcount(pos.pieces(pt) & ~pos.promoted_pawns());
+            for (Color c : {WHITE, BLACK})
+                n[pt - PAWN] += pos.pocket(c).count(pt);
+        }
+        n[0] += popcount(pos.promoted_pawns());
+
+        return n;
+    }
+
+    Bitboard PositionIndexer::squares(const Position &pos, const Slot &slot)
+    {
+        Bitboard b = pos.pieces(color_of(slot.piece), type_of(slot.piece));
+        return slot.promoted ? b & pos.promoted_pawns() : b & ~pos.promoted_pawns();
+    }
+
+    bool PositionIndexer::covers(const Position &pos) const
+    {
+        std::array<int, 4> n = material(pos);
+
+        for (size_t gi = 0; gi < groups.size(); ++gi)
+            if (n[gi] != groups[gi].n)
+                return false;
+        return true;
+    }
+
+    uint64_t PositionIndexer::rank(const Position &pos) const
+    {
+        assert(covers(pos));
+
+        const Square wksq = pos.square<KING>(WHITE);
+        const Square bksq = pos.square<KING>(BLACK);
+
+        uint64_t kings =
+            pos.side_to_move() * KingPairs + wksq * (SQUARE_NB - 1) + bksq - (bksq > wksq);
+
+        // Board squares of each group go in the combinatorial number system,
+        // relative to the squares left free by the earlier groups
+        Bitboard freeBB = ~(square_bb(wksq) | square_bb(bksq));
+        uint64_t placement = 0, radix = 1;
+        size_t id = 0;
+
+        for (const Group &g : groups)
+        {
+            size_t code = 0;
+            for (size_t i = g.slots.size(); i-- > 0;)
+            {
+                const Slot &slot = g.slots[i];
+                const Color c = color_of(slot.piece);
+                int count = slot.pocket ? pos.pocket(c).count(type_of(slot.piece))
+                                        : popcount(squares(pos, slot));
+                code = code * (g.n + 1) + count;
+            }
+            id = id * g.splits.size() + g.splitId[code];
+
+            for (const Slot &slot : g.slots)
+            {
+                if (slot.pocket)
+                    continue;
+
+                Bitboard b = squares(pos, slot);
+                int n = popcount(freeBB), k = popcount(b);
+                uint64_t sub = 0;
+
+                for (int i = 1; b; ++i)
+                    sub += Binomial[popcount(freeBB & (square_bb(pop_lsb(b)) - 1))][i];
+
+                placement += sub * radix;
+                radix *= Binomial[n][k];
+                freeBB &= ~squares(pos, slot);
+            }
+        }
+
+        return kings * perKings + offset[id] + placement;
+    }
+
+    bool PositionIndexer::unrank(uint64_t index, Position &pos, StateInfo *si) const
+    {
+        assert(index < total);
+
+        uint64_t kings = index / perKings;
+        index %= perKings;
+
+        const Color us = Color(kings / KingPairs);
+        const Square wksq = Square(kings % KingPairs / (SQUARE_NB - 1));
+        Square bksq = Square(kings % (SQUARE_NB - 1));
+        if (bksq >= wksq)
+            ++bksq;
+
+        if (attacks_bb<KING>(wksq) & bksq)
+            return false;
+
+        size_t id = std::upper_bound(offset.begin(), offset.end(), index) - offset.begin() - 1;
+        uint64_t placement = index - offset[id];
+
+        PackedPosition pp{};
+        pp.board = uint64_t(W_KING) << (4 * wksq) | uint64_t(B_KING) << (4 * bksq);
+        pp.side = uint8_t(us);
+
+        // Split ids are in mixed radix with the last group as the lowest digit
+        std::array<size_t, 4> splitIds;
+        for (size_t gi = groups.size(); gi-- > 0; id /= groups[gi].splits.size())
+            splitIds[gi] = id % groups[gi].splits.size();
+
+        Bitboard freeBB = ~(square_bb(wksq) | square_bb(bksq));
+
+        for (size_t gi = 0; gi < groups.size(); ++gi)
+        {
+            const Group &g = groups[gi];
+            const auto &split = g.splits[splitIds[gi]];
+
+            for (size_t i = 0; i < g.slots.size(); ++i)
+            {
+                const Slot &slot = g.slots[i];
+                const int k = split[i];
+
+                if (slot.pocket)
+                {
+                    int shift = 2 * (type_of(slot.piece) - PAWN);
+                    pp.pockets[color_of(slot.piece)] |= uint8_t(k << shift);
+                    continue;
+                }
+
+                const uint64_t n = Binomial[popcount(freeBB)][k];
+                uint64_t sub = placement % n;
+                placement /= n;
+
+                // Greedy decoding of the combinatorial number system
+                Bitboard b = 0;
+                for (int j = k, p = popcount(freeBB) - 1; j > 0; --j)
+                {
+                    while (Binomial[p][j] > sub)
+                        --p;
+                    sub -= Binomial[p][j];
+                    b |= nth_square(freeBB, p);
+                }
+
+                Bitboard lastRank = color_of(slot.piece) == WHITE ? Rank4BB : Rank1BB;
+                if (type_of(slot.piece) == PAWN && (b & lastRank))
+                    return false;
+
+                freeBB &= ~b;
+                if (slot.promoted)
+                    pp.promoted |= b;
+                while (b)
+                    pp.board |= uint64_t(slot.piece) << (4 * pop_lsb(b));
+            }
+        }
+
+        pos.set(pp, si);
+
+        // The side that just moved cannot have left its king in check
+        return !pos.attackers_to_exist(pos.square<KING>(~us), pos.pieces(), us);
+    }
+
+} // namespace tiny::retro
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "../core/position.h"
+
+namespace tiny::retro
+{
+
+    // PositionIndexer is a perfect index of all positions with a given
+    // material. Material is conserved in Tinyhouse: every non-king piece is
+    // either on the board, possibly as a promoted pawn, or in a pocket. So
+    // positions can be enumerated combinatorially instead of hashed, and a
+    // table over them is a flat array with no keys stored.
+    //
+    // An index is a mixed radix number made of the side to move, the two king
+    // squares, how each kind of piece is split between colours, board and
+    // pockets (pawns also by promotion), and finally the board squares of
+    // each group of identical pieces in the combinatorial number system.
+    //
+    // rank() is a bijection from the positions with this material onto
+    // [0, size()). Not every index is a legal position: unrank() rejects
+    // touching kings, pawns on their last rank and a side not to move that
+    // is in check.
+    class PositionIndexer
+    {
+    public:
+        // Indexes the positions with the material of pos
+        explicit PositionIndexer(const Position &pos);
+
+        uint64_t size() const { return total; }
+
+        // True if pos has the material of this indexer, so it can be ranked
+        bool covers(const Position &pos) const;
+
+        uint64_t rank(const Position &pos) const;
+
+        // Sets pos to the position with the given index, with si as its only
+        // state. Returns false if that is not a legal position.
+        bool unrank(uint64_t index, Position &pos, StateInfo *si) const;
+
+        // Counts the pieces of each kind, whatever their colour and place:
+        // pawns, promoted or not, and the original horses, ferzes and wazirs
+        static std::array<int, 4> material(const Position &pos);
+
+    private:
+        static constexpr int MaxSlots = 10;
+
+        // Where the pieces of a group can be. A board slot is a piece on a
+        // square; a pocket slot counts pieces in a pocket.
+        struct Slot
+        {
+            Piece piece;
+            bool promoted;
+            bool pocket;
+        };
+
+        // The pieces of one kind: the pawns (including promoted ones) or the
+        // original horses, ferzes or wazirs. A split gives the count of each
+        // slot; splitId maps the counts, in base n + 1, to the split.
+        struct Group
+        {
+            int n = 0;
+            std::vector<Slot> slots;
+            std::vector<std::array<uint8_t, MaxSlots>> splits;
+            std::vector<uint32_t> splitId;
+        };
+
+        static Bitboard squares(const Position &pos, const Slot &slot);
+
+        std::array<Group, 4> groups;
+        std::vector<uint64_t> offset; // first placement of each split combination
+        uint64_t perKings = 0, total = 0;
+    };
+
+} // namespace tiny::retro
@@ -0,0 +1,165 @@
+#include "progress.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+// Version 2 resolves GetProcessMemoryInfo to kernel32, no psapi.lib needed
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#endif
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <system_error>
+
+namespace tiny::retro
+{
+
+    namespace
+    {
+        // Resident set size of the process, 0 if unknown
+        size_t resident_bytes()
+        {
+#if defined(__linux__)
+            std::ifstream statm("/proc/self/statm");
+            size_t pages = 0, resident = 0;
+            statm >> pages >> resident;
+            return resident * size_t(::sysconf(_SC_PAGESIZE));
+#elif defined(_WIN32)
+            PROCESS_MEMORY_COUNTERS pmc;
+            return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))
+                       ? size_t(pmc.WorkingSetSize)
+                       : 0;
+#else
+            return 0;
+#endif
+        }
+
+        double mb(size_t bytes) { return bytes / double(1 << 20); }
+    } // namespace
+
+    Progress::Progress(size_t seconds, const std::string &jsonPath)
+        : interval(seconds), jsonPath(jsonPath), start(Clock::now()), last(start), phaseStart(start)
+    {
+    }
+
+    bool Progress::due() const { return Clock::now() - last >= interval; }
+
+    void Progress::restart() { restarted = true; }
+
+    void Progress::report(const SolveStats &s)
+    {
+        const Clock::time_point now = Clock::now();
+        const double elapsed = std::chrono::duration<double>(now - start).count();
+        const double sinceLast = std::chrono::duration<double>(now - last).count();
+
+        // The work of the forward phase is expanding nodes, of the
+        // retrograde one propagating them. "done" ends the retrograde phase.
+        const bool forward = std::strcmp(s.phase, "forward") == 0;
+        const bool done = std::strcmp(s.phase, "done") == 0;
+        const uint64_t work = forward ? s.expanded : s.propagated;
+
+        // Rates start over with each kind of work, or after a resume. The
+        // first report of a phase has nothing to measure them on yet, but a
+        // new solve is measured from the start.
+        if (forward != lastForward || restarted)
+        {
+            restarted = false;
+            phaseStart = now;
+            phaseWork = work;
+            lastNodes = s.nodes;
+            lastWork = work;
+        }
+        const double inPhase = std::chrono::duration<double>(now - phaseStart).count();
+
+        // Negative if unknown. The done line gives the average of the phase,
+        // and nodes are only found in the forward phase.
+        double nodeRate = -1, rate = -1;
+        if (done && inPhase > 0)
+            rate = (work - phaseWork) / inPhase;
+        else if (!done && now != phaseStart && sinceLast > 0)
+        {
+            rate = (work - lastWork) / sinceLast;
+            if (forward)
+                nodeRate = (s.nodes - lastNodes) / sinceLast;
+        }
+        const double eta = rate > 0 && !done ? s.queued / rate : -1;
+        const size_t rss = resident_bytes();
+
+        std::cout << "[solve] " << s.phase << " " << std::fixed << std::setprecision(0) << elapsed
+                  << "s: " << s.nodes << " nodes";
+        if (nodeRate >= 0)
+            std::cout << " (" << nodeRate << "/s)";
+        std::cout << ", " << work << (forward ? " expanded" : " propagated");
+        if (rate >= 0)
+            std::cout << " (" << rate << (done ? "/s average" : "/s") << ")";
+        std::cout << ", " << s.queued << " queued";
+        if (std::strcmp(s.phase, "retro") == 0)
+            std::cout << " in layer " << s.layer;
+        std::cout << ", W " << s.wins << " L " << s.losses << " D " << s.draws << ", load "
+                  << std::setprecision(2) << s.loadFactor << ", MB index " << std::setprecision(1)
+                  << mb(s.indexBytes) << " nodes " << mb(s.nodeBytes) << " positions "
+                  << mb(s.positionBytes) << " counters " << mb(s.counterBytes) << " layer "
+                  << mb(s.layerBytes) << " rss " << mb(rss);
+        if (eta >= 0)
+            std::cout << ", eta " << std::setprecision(0) << eta << "s";
+        std::cout << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+
+        if (!jsonPath.empty())
+            write_json(s, elapsed, nodeRate, rate, eta, rss);
+
+        last = now;
+        lastNodes = s.nodes;
+        lastWork = work;
+        lastForward = forward;
+    }
+
+    // Written to a temporary file and renamed, so readers never see half a file
+    void Progress::write_json(const SolveStats &s, double elapsed, double nodeRate, double rate,
+                              double eta, size_t rss) const
+    {
+        const std::string tmp = jsonPath + ".tmp";
+        {
+            std::ofstream out(tmp);
+            out << std::fixed << std::setprecision(3);
+            out << "{\n"
+                << "  \"phase\": \"" << s.phase << "\",\n"
+                << "  \"elapsed_seconds\": " << elapsed << ",\n"
+                << "  \"nodes\": " << s.nodes << ",\n"
+                << "  \"nodes_per_second\": " << nodeRate << ",\n"
+                << "  \"expanded\": " << s.expanded << ",\n"
+                << "  \"propagated\": " << s.propagated << ",\n"
+                << "  \"queued\": " << s.queued << ",\n"
+                << "  \"layer\": " << s.layer << ",\n"
+                << "  \"work_per_second\": " << rate << ",\n"
+                << "  \"eta_seconds\": " << eta << ",\n"
+                << "  \"wins\": " << s.wins << ",\n"
+                << "  \"losses\": " << s.losses << ",\n"
+                << "  \"draws\": " << s.draws << ",\n"
+                << "  \"index_load_factor\": " << s.loadFactor << ",\n"
+                << "  \"bytes\": {\n"
+                << "    \"index\": " << s.indexBytes << ",\n"
+                << "    \"nodes\": " << s.nodeBytes << ",\n"
+                << "    \"positions\": " << s.positionBytes << ",\n"
+                << "    \"counters\": " << s.counterBytes << ",\n"
+                << "    \"layer\": " << s.layerBytes << ",\n"
+                << "    \"resident\": " << rss << "\n"
+                << "  }\n"
+                << "}\n";
+            if (!out)
+                return;
+        }
+        // std::rename() does not replace an existing file on Windows
+        std::error_code ec;
+        std::filesystem::rename(tmp, jsonPath, ec);
+    }
+
+} // namespace tiny::retro
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tiny::retro
+{
+
+    // A snapshot of a running solve. The counts are kept up to date as the
+    // solve goes, so taking one does not scan the node arrays.
+    struct SolveStats
+    {
+        const char *phase = "forward"; // "forward", "retro" or "done"
+        uint64_t nodes = 0;            // symmetry classes found
+        uint64_t expanded = 0;         // forward: nodes expanded
+        uint64_t queued = 0;           // nodes waiting: to be expanded, or in the current layer
+        uint32_t layer = 0;            // retro: DTM layer being propagated
+        uint64_t propagated = 0;       // retro: solved nodes whose parents are done
+        uint64_t wins = 0, losses = 0, draws = 0;
+        double loadFactor = 0;         // of the position index
+
+        // Bytes held by each structure. With --max-mem the node data is
+        // mapped from scratch files and may be only partly resident.
+        size_t indexBytes = 0, nodeBytes = 0, positionBytes = 0, counterBytes = 0,
+               layerBytes = 0;
+    };
+
+    // Progress reports a solve every few seconds, as a line on stdout and,
+    // if a path is given, as a JSON file rewritten in place, for tools that
+    // follow the run. Rates and the ETA are worked out between reports; the
+    // JSON has -1 for those not known.
+    class Progress
+    {
+    public:
+        Progress(size_t seconds, const std::string &jsonPath);
+
+        // True if a report is due
+        bool due() const;
+
+        // Measures the rates afresh from the next report on, as the counts
+        // of a resumed solve include work done before
+        void restart();
+
+        // Reports s now. The ETA is the time to clear the queued work at
+        // the current rate, as later work cannot be known in advance. The
+        // "done" report gives the average rate of the retrograde phase.
+        void report(const SolveStats &s);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void write_json(const SolveStats &s, double elapsed, double nodeRate, double rate,
+                        double eta, size_t rss) const;
+
+        std::chrono::seconds interval;
+        std::string jsonPath;
+        Clock::time_point start, last, phaseStart;
+        uint64_t lastNodes = 0, lastWork = 0, phaseWork = 0;
+        bool lastForward = true, restarted = false;
+    };
+
+} // namespace tiny::retro
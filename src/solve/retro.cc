@@ -1,13 +1,25 @@
 #include "retro.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <deque>
-#include <unordered_map>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
-#include "../core/move.h"
+#include "../core/movegen.h"
 #include "../core/position.h"
+#include "../core/unmovegen.h"
+#include "checkpoint.h"
+#include "mapped_array.h"
+#include "position_index.h"
+#include "position_indexer.h"
+#include "progress.h"
 
 namespace tiny::retro
 {
@@ -27,188 +39,460 @@ namespace tiny::retro
         uint16_t dtm = 0;
         Move best = Move(0);
         uint16_t outdeg = 0;
-        uint16_t remaining = 0; // for loss detection
     };
 
-    struct Parents
+    // A node is a class of positions equal up to mirroring and colour flip,
+    // all of which have the same outcome. The canonical key also tells apart
+    // positions that differ only in which pieces are promoted pawns.
+    Key node_key(const Position &pos)
     {
-        std::vector<uint32_t> ids;
+        Symmetry sym;
+        return pos.canonical_key(sym);
+    }
+
+    void print_index_stats(const ShardedPositionIndex &index, size_t nodeBytes)
+    {
+        PositionIndex::Stats s = index.stats();
+        double n = s.size ? double(s.size) : 1.0;
+
+        std::cout << "[solve] index: " << s.size << " positions in " << s.capacity << " slots, "
+                  << std::fixed << std::setprecision(1) << s.bytes / n << " bytes/node (+"
+                  << nodeBytes / n << " node data), probe length avg " << std::setprecision(2)
+                  << s.avgProbe << " max " << s.maxProbe << "\n";
+        std::cout.unsetf(std::ios::floatfield);
+    }
+
+    // Runs f(thread, begin, end) over chunks of [0, n) on `threads` threads,
+    // the calling one (thread 0) included, and returns once all are done
+    template <typename F>
+    void parallel_for(size_t n, size_t threads, size_t chunk, F &&f)
+    {
+        std::atomic<size_t> next{0};
+
+        auto worker = [&](size_t idx)
+        {
+            for (size_t b; (b = next.fetch_add(chunk)) < n;)
+                f(idx, b, std::min(b + chunk, n));
+        };
+
+        threads = std::clamp(threads, size_t(1), std::max((n + chunk - 1) / chunk, size_t(1)));
+
+        std::vector<std::thread> helpers;
+        for (size_t i = 1; i < threads; ++i)
+            helpers.emplace_back(worker, i);
+        worker(0);
+        for (auto &th : helpers)
+            th.join();
+    }
+
+    // A node found while expanding a batch, waiting for its slot in positions[]
+    struct NewNode
+    {
+        uint32_t id;
+        PackedPosition pos;
+    };
+
+    // A node solved by propagation, as logged in checkpoints
+    struct Solved
+    {
+        uint32_t id;
+        uint8_t status;
+        uint16_t dtm;
     };
 
-    std::vector<TBRecord> build_wdl_dtm(const Position &start)
+    [[noreturn]] void bad_checkpoint(const std::string &dir, const char *why)
+    {
+        std::cerr << "[solve] error: cannot resume from " << dir << ": " << why << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::vector<TBRecord> build_wdl_dtm(const Position &start, const SolveOptions &options)
     {
-        using Key = uint64_t;
+        const size_t threads = std::max(options.threads, size_t(1));
+        constexpr size_t BatchSize = 1 << 16, ChunkSize = 256;
 
         // --- Storage ---
-        std::vector<Node> nodes;
-        std::vector<Parents> parents;
-        std::vector<Key> keys;
-        keys.reserve(1 << 20);
-
-        std::unordered_map<Key, uint32_t> index;
-        index.reserve(1 << 20);
-
-        // Work queues
-        std::deque<uint32_t> q;
-
-        // Helper to create node for unseen key
-        auto add_node = [&](Key k) -> uint32_t
-        {
-            auto it = index.find(k);
-            if (it != index.end())
-                return it->second;
-            uint32_t id = static_cast<uint32_t>(nodes.size());
-            index.emplace(k, id);
-            nodes.emplace_back();
-            parents.emplace_back();
-            keys.push_back(k);
-            return id;
+        // Every node keeps its packed position; predecessors are regenerated
+        // from it with un-moves rather than stored as edge lists. Without a
+        // memory budget the arrays are plain vectors, else scratch files.
+        const bool outOfCore = options.maxMemory != 0;
+        auto scratch = [&](const char *name)
+        { return outOfCore ? options.scratchPrefix + "." + name + ".tmp" : std::string(); };
+
+        MappedArray<Node> nodes(scratch("nodes"));
+        MappedArray<PackedPosition> positions(scratch("positions"));
+        nodes.reserve(options.expectedPositions);
+        positions.reserve(options.expectedPositions);
+
+        ShardedPositionIndex index(options.expectedPositions);
+
+        // The index is probed at random and stays in memory. Node data over
+        // what is left of the budget is written back and dropped, up to the
+        // first `upto` nodes; it is read back from disk when next touched.
+        auto trim = [&](size_t upto)
+        {
+            const size_t budget = options.maxMemory - std::min(options.maxMemory, index.bytes());
+            if (!outOfCore || nodes.size() * (sizeof(Node) + sizeof(PackedPosition)) <= budget)
+                return;
+
+            nodes.release(0, upto);
+            positions.release(0, upto);
         };
 
-        // ------------- Phase A: forward reachability graph -------------
-        // BFS from start; along the way, capture outdegrees and reverse edges.
-        std::deque<uint32_t> frontier;
+        // --- Progress ---
+        Progress progress(options.progressSeconds, options.statsPath);
+        SolveStats stats;
 
-        Position root = start;
-        uint32_t rootId = add_node(root.key());
-        frontier.push_back(rootId);
+        auto count = [&](uint8_t status)
+        {
+            stats.wins += status == WIN;
+            stats.losses += status == LOSS;
+        };
 
-        // Keep a parallel vector of materialized Positions for frontier expansion.
-        // We do not store Positions for every node; we regenerate via do/undo.
-        // For BFS we carry only the root Position and replay moves incrementally.
-        // Expansion is done by reconstructing from a stored Position snapshot,
-        // but to keep this module abstract/simple, we expand from `root` and
-        // maintain a stack during DFS-like local expansion.
+        // Fills in the figures that are read off the structures
+        auto report = [&](const char *phase, uint64_t queued)
+        {
+            stats.phase = phase;
+            stats.nodes = nodes.size();
+            stats.queued = queued;
+            stats.loadFactor = double(index.size()) / std::max(index.capacity(), size_t(1));
+            stats.indexBytes = index.bytes();
+            stats.nodeBytes = nodes.capacity() * sizeof(Node);
+            stats.positionBytes = positions.capacity() * sizeof(PackedPosition);
+            progress.report(stats);
+        };
 
-        // To avoid storing every Position snapshot, do a graph build with
-        // on-the-fly expansion using a work stack:
-        std::vector<std::pair<uint32_t, Position>> expand;
-        expand.reserve(1024);
-        expand.emplace_back(rootId, root);
+        // --- Checkpoints ---
+        // Nodes only change while they are expanded, and positions are only
+        // added, so Phase A snapshots just add what is new. Phase B logs the
+        // nodes it solves and saves the counters and the next layer whole.
+        // The index is not saved: it is rebuilt from the positions.
+        std::unique_ptr<Checkpoint> checkpoint;
+        Checkpoint::State saved; // as of the last snapshot
+        std::vector<Solved> log; // nodes solved since the last snapshot
+        auto lastSave = std::chrono::steady_clock::now();
 
-        while (!expand.empty())
+        if (!options.checkpointDir.empty())
+            checkpoint = std::make_unique<Checkpoint>(options.checkpointDir);
+
+        if (checkpoint && options.resume && checkpoint->load(saved))
+        {
+            if (saved.startKey != node_key(start))
+                bad_checkpoint(options.checkpointDir, "it is for another position");
+
+            nodes.resize(saved.nodes);
+            positions.resize(saved.nodes);
+            if (!checkpoint->read_update("positions", 0, positions.data(), saved.nodes) ||
+                !checkpoint->read_update("nodes", 0, nodes.data(),
+                                         saved.phase == 1 ? saved.expanded : saved.nodes))
+                bad_checkpoint(options.checkpointDir, "node data is missing");
+
+            for (const Node &n : nodes)
+                count(n.status);
+
+            parallel_for(saved.nodes, threads, ChunkSize, [&](size_t, size_t b, size_t e)
+                         {
+                             StateInfo si;
+                             Position pos;
+                             for (size_t id = b; id < e; ++id)
+                             {
+                                 pos.set(positions[id], &si);
+                                 index.restore(node_key(pos), uint32_t(id));
+                             }
+                         });
+
+            std::cout << "[solve] resumed from " << options.checkpointDir << ": " << saved.nodes
+                      << " nodes, " << (saved.phase == 1 ? saved.expanded : saved.nodes)
+                      << " expanded, " << saved.layers << " layers propagated\n";
+            progress.restart();
+        }
+        else
         {
-            auto [pid, pos] = expand.back();
-            expand.pop_back();
+            saved = {};
+            saved.startKey = node_key(start);
+
+            bool inserted;
+            index.insert(saved.startKey, inserted);
+            nodes.resize(1);
+            positions.push_back(start.pack());
+        }
+
+        auto due = [&]
+        {
+            return checkpoint && std::chrono::steady_clock::now() - lastSave >=
+                                     std::chrono::seconds(options.checkpointSeconds);
+        };
+
+        auto save = [&](Checkpoint::Snapshot &s)
+        {
+            saved = s.state;
+            checkpoint->save(std::move(s));
+            lastSave = std::chrono::steady_clock::now();
+        };
+
+        // Adds the nodes expanded and the positions found since the last snapshot
+        auto add_nodes = [&](Checkpoint::Snapshot &s, size_t expanded)
+        {
+            s.update("nodes", saved.expanded, nodes.data() + saved.expanded,
+                     expanded - saved.expanded);
+            s.update("positions", saved.nodes, positions.data() + saved.nodes,
+                     nodes.size() - saved.nodes);
+            s.state.expanded = expanded;
+            s.state.nodes = nodes.size();
+        };
+
+        // ------------- Phase A: forward reachability graph -------------
+        // Nodes are expanded in id order, a batch at a time, by threads that
+        // share the position index. A parent is expanded by a single thread,
+        // so its counters need no synchronization. The node arrays cannot grow
+        // while they are read, so new nodes are buffered per thread and stored
+        // after the batch.
+
+        std::vector<std::vector<NewNode>> found(threads);
+
+        auto expand = [&](std::vector<NewNode> &out, uint32_t pid)
+        {
+            StateInfo si, st;
+            Position pos;
+            pos.set(positions[pid], &si);
 
             // Generate legal moves/drops from pos
             MoveList<LEGAL> ml(pos);
-            nodes[pid].outdeg = static_cast<uint16_t>(ml.size());
-            nodes[pid].remaining = nodes[pid].outdeg;
 
             if (ml.size() == 0)
             {
-                // Terminal (mate or stalemate-as-win); status assigned later.
-                continue;
+                // Checkmate is a loss, stalemate a win for the side to move
+                nodes[pid].status = pos.checkers() ? LOSS : WIN;
+                nodes[pid].dtm = 0;
+                return;
             }
 
-            StateInfo st; // per-Position undo info
+            Key children[MAX_MOVES];
+            size_t n = 0;
+
             for (Move m : ml)
             {
                 pos.do_move(m, st);
-                Key ck = pos.key();
+                bool isNew;
+                uint32_t id = index.insert(children[n++] = node_key(pos), isNew);
+                if (isNew)
+                    out.push_back({id, pos.pack()});
+                pos.undo_move(m);
+            }
 
-                uint32_t cid = add_node(ck);
-                parents[cid].ids.push_back(pid);
+            // Moves to symmetric children reach the same node, so the
+            // outdegree counts distinct children
+            std::sort(children, children + n);
+            n = std::unique(children, children + n) - children;
+            nodes[pid].outdeg = static_cast<uint16_t>(n);
+        };
 
-                // Push child for further expansion only if we just discovered it.
-                if (nodes.size() == index.size() && cid == static_cast<uint32_t>(nodes.size() - 1))
-                {
-                    // Newly added node => we need to expand it at some point.
-                    expand.emplace_back(cid, pos);
-                }
-                pos.undo_move(m);
+        size_t begin = saved.phase == 2 ? nodes.size() : saved.expanded;
+        while (begin < nodes.size())
+        {
+            const size_t end = std::min(nodes.size(), begin + BatchSize);
+
+            parallel_for(end - begin, threads, ChunkSize, [&](size_t idx, size_t b, size_t e)
+                         {
+                             for (size_t pid = begin + b; pid < begin + e; ++pid)
+                                 expand(found[idx], uint32_t(pid));
+                         });
+
+            for (size_t pid = begin; pid < end; ++pid)
+                count(nodes[pid].status);
+
+            nodes.resize(index.size());
+            positions.resize(index.size());
+            for (auto &out : found)
+            {
+                for (const NewNode &n : out)
+                    positions[n.id] = n.pos;
+                out.clear();
             }
-        }
 
-        // ------------- Phase B: label terminals and enqueue -------------
-        // We need to revisit each node to check "no legal moves" and "in check".
-        // Do a pass by reconstructing positions via a second crawl:
-        std::vector<uint8_t> initialStatus(nodes.size(), UNKNOWN);
+            if (due())
+            {
+                Checkpoint::Snapshot s;
+                s.state = saved;
+                s.state.phase = 1;
+                add_nodes(s, end);
+                save(s);
+            }
 
-        // Minimal reconstruction: walk all nodes by a hash->Position map would
-        // require a transposition table of Positions. To stay abstract here,
-        // we re-expand from root and mark terminals as we see them.
-        // (In a full implementation, you'd maintain a compact TT or cache.)
+            stats.expanded = end;
+            if (progress.due())
+                report("forward", nodes.size() - end);
 
-        // Markers to avoid quadratic work:
-        std::vector<uint8_t> seen(nodes.size(), 0);
-        std::deque<std::pair<uint32_t, Position>> work;
-        work.emplace_back(rootId, root);
-        seen[rootId] = 1;
+            // Expanded nodes are not needed again before Phase B
+            trim(end);
+            begin = end;
+        }
 
-        while (!work.empty())
+        print_index_stats(index, nodes.capacity() * sizeof(Node) +
+                                     positions.capacity() * sizeof(PackedPosition));
+
+        // How dense a flat table over the perfect index of this material would be
+        PositionIndexer indexer(start);
+        std::cout << "[solve] perfect index: " << indexer.size() << " indices for " << nodes.size()
+                  << " reachable symmetry classes\n";
+
+        // ------------- Phase B: retrograde propagation -------------
+        // Solved nodes are propagated a DTM layer at a time: the parents
+        // solved by layer d form layer d + 1. Each layer is split between the
+        // threads, and the result does not depend on the order in which its
+        // nodes are handled.
+        //
+        // remaining[p] counts the children of p not yet known to win for the
+        // opponent, and drops to 0 once p is solved. The thread that takes it
+        // to 0 owns p and is the only one to write its status.
+        MappedArray<std::atomic<uint16_t>> remaining(scratch("counters"));
+        remaining.resize(nodes.size());
+
+        // Decrements remaining[p], or zeroes it if `all`, unless p is solved.
+        // Returns true if this solved p.
+        auto settle = [&](uint32_t p, bool all)
         {
-            auto [pid, pos] = work.front();
-            work.pop_front();
-
-            MoveList<LEGAL> ml(pos);
-            if (ml.size() == 0)
+            uint16_t r = remaining[p].load(std::memory_order_relaxed);
+            while (r && !remaining[p].compare_exchange_weak(r, all ? 0 : r - 1,
+                                                            std::memory_order_relaxed))
             {
-                // terminal
-                if (pos.in_check())
-                {
-                    nodes[pid].status = LOSS; // side-to-move is checkmated -> loss
-                    nodes[pid].dtm = 0;
-                }
-                else
-                {
-                    nodes[pid].status = WIN; // stalemate-as-win per rules
-                    nodes[pid].dtm = 0;
-                }
-                q.push_back(pid);
             }
+            return r && (all || r == 1);
+        };
 
-            StateInfo st;
-            for (Move m : ml)
+        MappedArray<uint32_t> layer(scratch("layer"));
+        uint32_t layers = 0;
+
+        auto save_retro = [&]
+        {
+            Checkpoint::Snapshot s;
+            s.state = saved;
+            s.state.phase = 2;
+            s.state.layers = layers;
+            add_nodes(s, nodes.size());
+            s.update("solved", saved.solved, log.data(), log.size());
+            s.state.solved += log.size();
+            s.state.frontier = layer.size();
+            s.write("counters", remaining.data(), remaining.size());
+            s.write("layer", layer.data(), layer.size());
+            save(s);
+            log.clear();
+        };
+
+        if (saved.phase == 2)
+        {
+            layers = saved.layers;
+            layer.resize(saved.frontier);
+            log.resize(saved.solved);
+            if (!checkpoint->read_file("counters", remaining.data(), remaining.size()) ||
+                !checkpoint->read_file("layer", layer.data(), layer.size()) ||
+                !checkpoint->read_update("solved", 0, log.data(), log.size()))
+                bad_checkpoint(options.checkpointDir, "propagation data is missing");
+
+            for (const Solved &r : log)
             {
-                pos.do_move(m, st);
-                auto it = index.find(pos.key());
-                uint32_t cid = it->second;
-                if (!seen[cid])
-                {
-                    seen[cid] = 1;
-                    work.emplace_back(cid, pos);
-                }
-                pos.undo_move(m);
+                nodes[r.id].status = r.status;
+                nodes[r.id].dtm = r.dtm;
+                count(r.status);
             }
+            log.clear();
+
+            // All solved nodes but those of the next layer are propagated
+            stats.propagated = stats.wins + stats.losses - layer.size();
+        }
+        else
+        {
+            for (size_t i = 0; i < nodes.size(); ++i)
+                remaining[i].store(nodes[i].outdeg, std::memory_order_relaxed);
+
+            // Terminals, and nothing else, have no children: they are layer 0
+            for (uint32_t id = 0; id < nodes.size(); ++id)
+                if (nodes[id].status != UNKNOWN)
+                    layer.push_back(id);
+
+            // Phase A is over in any case
+            if (checkpoint)
+                save_retro();
         }
 
-        // ------------- Phase C: retrograde propagation -------------
-        while (!q.empty())
+        std::vector<std::vector<uint32_t>> solved(threads), parents(threads);
+
+        // The parents of a solved node are its un-moves. Predecessors that are
+        // not reachable from the start are not in the index and are skipped.
+        // Like the outdegree, each distinct parent node is counted once.
+        auto propagate = [&](size_t idx, uint32_t v)
         {
-            uint32_t v = q.front();
-            q.pop_front();
+            const bool lost = nodes[v].status == LOSS;
+            const uint16_t dtm = static_cast<uint16_t>(nodes[v].dtm + 1);
 
-            uint8_t vstat = nodes[v].status;
-            uint16_t vdtm = nodes[v].dtm;
+            StateInfo si, st;
+            Position pos;
+            pos.set(positions[v], &si);
 
-            for (uint32_t p : parents[v].ids)
+            std::vector<uint32_t> &ps = parents[idx];
+            ps.clear();
+            for (const UnMove &um : UnMoveList(pos))
             {
-                if (nodes[p].status != UNKNOWN)
-                    continue;
+                Position prev = pos;
+                prev.retract(um, &st);
 
-                if (vstat == LOSS)
-                {
-                    // Parent can move to a losing child -> parent is WIN
-                    nodes[p].status = WIN;
-                    nodes[p].dtm = static_cast<uint16_t>(vdtm + 1);
-                    // (best move to v is filled later in a refinement pass)
-                    q.push_back(p);
-                }
-                else if (vstat == WIN)
+                uint32_t p = index.find(node_key(prev));
+                if (p != ShardedPositionIndex::NONE)
+                    ps.push_back(p);
+            }
+            std::sort(ps.begin(), ps.end());
+            ps.erase(std::unique(ps.begin(), ps.end()), ps.end());
+
+            // A parent that can move to a lost child wins; one whose children
+            // all win for the opponent loses
+            for (uint32_t p : ps)
+                if (settle(p, lost))
                 {
-                    // One more child proven WIN for the opponent
-                    if (nodes[p].remaining > 0)
-                        nodes[p].remaining--;
-                    if (nodes[p].remaining == 0)
-                    {
-                        nodes[p].status = LOSS;
-                        nodes[p].dtm = static_cast<uint16_t>(vdtm + 1);
-                        q.push_back(p);
-                    }
+                    nodes[p].status = lost ? WIN : LOSS;
+                    nodes[p].dtm = dtm;
+                    solved[idx].push_back(p);
                 }
+        };
+
+        stats.expanded = nodes.size();
+        stats.counterBytes = remaining.capacity() * sizeof(uint16_t);
+        report("retro", layer.size());
+
+        while (!layer.empty())
+        {
+            parallel_for(layer.size(), threads, ChunkSize, [&](size_t idx, size_t b, size_t e)
+                         {
+                             for (size_t i = b; i < e; ++i)
+                                 propagate(idx, layer[i]);
+                         });
+            stats.propagated += layer.size();
+
+            // Sorted, the next layer is walked in memory order
+            layer.clear();
+            for (auto &out : solved)
+            {
+                for (uint32_t p : out)
+                    layer.push_back(p);
+                out.clear();
             }
+            std::sort(layer.begin(), layer.end());
+            ++layers;
+
+            for (uint32_t p : layer)
+            {
+                count(nodes[p].status);
+                if (checkpoint)
+                    log.push_back({p, nodes[p].status, nodes[p].dtm});
+            }
+            if (due())
+                save_retro();
+
+            stats.layer = layers;
+            stats.layerBytes = layer.capacity() * sizeof(uint32_t);
+            if (progress.due())
+                report("retro", layer.size());
+
+            trim(nodes.size());
         }
 
         // Anything still UNKNOWN is a draw (cycles / repetition region).
@@ -221,22 +505,59 @@ namespace tiny::retro
             }
         }
 
-        // Optional: one more pass to assign a concrete best move for WIN/LOSS
-        // (shortest mate for WIN, longest resistance for LOSS).
-        // This requires a light re-walk from each node to find the child with
-        // the matching (wdl, dtm). Omitted here for brevity.
+        // ------------- Phase C: best moves -------------
+        // A won node at DTM d moves to a lost child at d - 1, the quickest
+        // win; a lost node at d to a won child at d - 1, the longest defence.
+        // The move is stored in the canonical frame of the node. Each thread
+        // only writes the best moves of its own nodes.
+        auto label = [&](uint32_t v)
+        {
+            const uint8_t want = nodes[v].status == WIN ? LOSS : WIN;
+            const uint16_t dtm = nodes[v].dtm;
+
+            StateInfo si, st;
+            Position pos;
+            pos.set(positions[v], &si);
+
+            Symmetry sym;
+            pos.canonical_key(sym);
+
+            for (Move m : MoveList<LEGAL>(pos))
+            {
+                pos.do_move(m, st);
+                const Node &child = nodes[index.find(node_key(pos))];
+                pos.undo_move(m);
+
+                if (child.status == want && child.dtm + 1 == dtm)
+                {
+                    nodes[v].best = transform(m, sym);
+                    return;
+                }
+            }
+        };
+
+        parallel_for(nodes.size(), threads, ChunkSize, [&](size_t, size_t b, size_t e)
+                     {
+                         for (size_t v = b; v < e; ++v)
+                             if (nodes[v].status != DRAW && nodes[v].dtm > 0)
+                                 label(uint32_t(v));
+                     });
+
+        stats.draws = nodes.size() - stats.wins - stats.losses;
+        report("done", 0);
 
         // ------------- Build TB records -------------
+        // Keys are only stored in the index
         std::vector<TBRecord> out;
         out.reserve(nodes.size());
-        for (size_t i = 0; i < nodes.size(); ++i)
-        {
-            WDL wdl = (nodes[i].status == WIN)    ? WDL::Win
-                      : (nodes[i].status == LOSS) ? WDL::Loss
-                                                  : WDL::Draw;
-            out.push_back(TBRecord{
-                keys[i], wdl, nodes[i].dtm, nodes[i].best});
-        }
+        index.for_each(
+            [&](Key k, uint32_t i)
+            {
+                WDL wdl = (nodes[i].status == WIN)    ? WDL::Win
+                          : (nodes[i].status == LOSS) ? WDL::Loss
+                                                      : WDL::Draw;
+                out.push_back(TBRecord{k, wdl, nodes[i].dtm, nodes[i].best});
+            });
         return out;
     }
 
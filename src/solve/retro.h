@@ -1,8 +1,10 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <string>
 #include <vector>
 
-#include "../core/move.h"
+#include "../core/movegen.h"
 #include "../core/position.h"
 
 namespace tiny::retro
@@ -17,14 +19,41 @@ namespace tiny::retro
 
     struct TBRecord
     {
-        uint64_t key; // Zobrist of Position (side-to-move included)
+        uint64_t key; // Position::canonical_key(), shared by symmetric positions
         WDL wdl;      // from the side-to-move perspective
         uint16_t dtm; // plies to mate (0 for terminals, saturate if needed)
-        Move best;    // packed move; 0 if none/Draw
+        Move best;    // packed move in the canonical frame; 0 if none/Draw
+    };
+
+    struct SolveOptions
+    {
+        size_t threads = 1;
+        // Presizes the position index and node arrays; a good estimate avoids
+        // growing them during the solve
+        size_t expectedPositions = 1 << 20;
+
+        // Memory budget in bytes, 0 for none. With a budget, node data goes
+        // to scratch files named after scratchPrefix and is dropped from
+        // memory whenever it would not fit next to the position index.
+        size_t maxMemory = 0;
+        std::string scratchPrefix = "tinyhouse";
+
+        // Snapshots of the solve go to checkpointDir, if set, after Phase A
+        // and then every checkpointSeconds. With resume, the solve goes on
+        // from the last snapshot there, if any.
+        std::string checkpointDir;
+        size_t checkpointSeconds = 600;
+        bool resume = false;
+
+        // A progress line goes to stdout every progressSeconds and, if
+        // statsPath is set, the same figures to a JSON file there
+        size_t progressSeconds = 10;
+        std::string statsPath;
     };
 
     // Compute the complete WDL+DTM table for all positions reachable from `start`.
-    // Returns one record per distinct position, sorted order not guaranteed.
-    std::vector<TBRecord> build_wdl_dtm(const Position &start);
+    // Returns one record per class of symmetric positions, sorted order not
+    // guaranteed.
+    std::vector<TBRecord> build_wdl_dtm(const Position &start, const SolveOptions &options = {});
 
 } // namespace tiny::retro
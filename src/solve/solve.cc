@@ -12,16 +12,19 @@
 
 using namespace tiny;
 
-int solve(const std::string &out_path)
+int solve(const std::string &out_path, const retro::SolveOptions &options,
+          const tb::WriteOptions &format)
 {
     std::cout << "[solve] starting solver...\n";
     std::cout << "output file: " << out_path << "\n";
 
-    // 1) Build initial Tinyhouse position (abstract factory).
-    Position start = Position::tinyhouse_start();
+    // 1) Build initial Tinyhouse position.
+    StateInfo si;
+    Position start;
+    start.set(StartFEN, &si);
 
     // 2) Run retrograde to compute WDL/DTM/best-move for all reachable positions.
-    std::vector<retro::TBRecord> records = retro::build_wdl_dtm(start);
+    std::vector<retro::TBRecord> records = retro::build_wdl_dtm(start, options);
 
     std::cout << "[solve] positions solved: " << records.size() << "\n";
 
@@ -33,13 +36,21 @@ int solve(const std::string &out_path)
               });
 
     // 4) Write tablebase to disk.
-    int rc = tb::write_binary(out_path, records);
+    int rc = tb::write_binary(out_path, records, format);
     if (rc != 0)
     {
         std::cerr << "[solve] error: failed to write tablebase (rc=" << rc << ")\n";
         return rc;
     }
 
+    // 5) Write the WDL bitbase the engine's search probes, next to it.
+    rc = tb::write_bitbase(out_path + ".wdl", records, start);
+    if (rc != 0)
+    {
+        std::cerr << "[solve] error: failed to write bitbase (rc=" << rc << ")\n";
+        return rc;
+    }
+
     std::cout << "[solve] done.\n";
     return 0;
 }
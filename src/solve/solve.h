@@ -1,7 +1,12 @@
 #pragma once
 #include <string>
 
+#include "retro.h"
+#include "tb_write.h"
+
 // Top-level solver entrypoint.
 // Given an output path, computes the full Tinyhouse solution
-// and writes it to disk.
-int solve(const std::string &out_path);
+// and writes it to disk in the given format, with a WDL bitbase for the
+// engine in out_path + ".wdl".
+int solve(const std::string &out_path, const tiny::retro::SolveOptions &options = {},
+          const tiny::tb::WriteOptions &format = {});
@@ -0,0 +1,86 @@
+#include "solve/tb_bitbase.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "solve/position_indexer.h"
+#include "solve/tb_format.h"
+
+namespace tiny::tb {
+
+Bitbase Bitbases;
+
+namespace {
+
+bool read_words(FILE* f, std::vector<uint64_t>& v, uint64_t n) {
+    v.resize(n);
+    return n == 0 || std::fread(v.data(), n * sizeof(uint64_t), 1, f) == 1;
+}
+
+} // namespace
+
+int Bitbase::open(const std::string& path) {
+    close();
+
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return 1;
+
+    int      rc = 0;
+    BBHeader h;
+    if (std::fread(&h, sizeof(h), 1, f) != 1 ||
+        std::memcmp(h.magic, BitbaseMagic, sizeof(h.magic)) != 0 ||
+        h.version != BitbaseVersion || h.levels > Mphf::MaxLevels)
+        rc = 2;
+
+    // The size must match before anything is allocated from the header
+    if (!rc) {
+        long size = -1;
+        if (std::fseek(f, 0, SEEK_END) == 0) size = std::ftell(f);
+        const uint64_t avail = size < long(sizeof(h)) ? 0 : uint64_t(size) - sizeof(h);
+        const uint64_t words = uint64_t(h.levels) + h.words + h.fallback;
+        if (size < 0 || words > avail / sizeof(uint64_t) || h.count > avail * 4 ||
+            (words + (h.count + 31) / 32) * sizeof(uint64_t) != avail)
+            rc = 3;
+        else if (std::fseek(f, long(sizeof(h)), SEEK_SET) != 0)
+            rc = 1;
+    }
+
+    std::vector<uint64_t> levels, hash, fallback;
+    if (!rc && (!read_words(f, levels, h.levels) || !read_words(f, hash, h.words) ||
+                !read_words(f, fallback, h.fallback) || !read_words(f, rows, (h.count + 31) / 32)))
+        rc = 1;
+    std::fclose(f);
+
+    if (!rc && (!mphf.assign(std::move(levels), std::move(hash), std::move(fallback)) ||
+                mphf.size() != h.count))
+        rc = 2;
+
+    if (rc) {
+        close();
+        return rc;
+    }
+    for (int i = 0; i < 4; ++i) material[i] = h.material[i];
+    return 0;
+}
+
+void Bitbase::close() {
+    mphf = Mphf();
+    rows.clear();
+    material = {};
+}
+
+bool Bitbase::probe(const Position& pos, retro::WDL& wdl) const {
+    if (rows.empty() || retro::PositionIndexer::material(pos) != material) return false;
+
+    Symmetry     sym;
+    const size_t i = mphf.lookup(pos.canonical_key(sym));
+    if (i >= mphf.size()) return false;
+
+    const unsigned v = (rows[i / 32] >> (i % 32 * 2)) & 3;
+    if (v > unsigned(retro::WDL::Win)) return false;
+
+    wdl = retro::WDL(v);
+    return true;
+}
+
+} // namespace tiny::tb
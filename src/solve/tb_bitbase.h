@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../core/position.h"
+#include "solve/retro.h"
+#include "solve/tb_mphf.h"
+
+namespace tiny::tb {
+
+// Bitbase answers only win, draw or loss, which is all the search needs, at
+// about 6 bits per symmetry class: 2 for the WDL and the rest for the perfect
+// hash that indexes it. It is read into memory whole, so a probe costs a
+// canonical key and a couple of cache misses, and can be made at every node.
+//
+// No keys are stored. Material is conserved in Tinyhouse, so a position
+// with other material than the solved one cannot be in the bitbase, and is
+// turned away; but a position of the right material that was not reachable
+// from the solved one gets an arbitrary answer.
+class Bitbase {
+   public:
+    // Reads the file. Returns 0 on success, 1 if it cannot be read, 2 on a
+    // bad header and 3 if the size does not match the header.
+    int  open(const std::string& path);
+    void close();
+
+    bool   is_open() const { return !rows.empty(); }
+    size_t size() const { return mphf.size(); }
+
+    // Looks up the WDL of pos, from the side to move. Returns false if pos
+    // has other material than the bitbase, or is not in it.
+    bool probe(const Position& pos, retro::WDL& wdl) const;
+
+   private:
+    Mphf                  mphf;
+    std::vector<uint64_t> rows;  // 2 bits each
+    std::array<int, 4>    material{};
+};
+
+// The bitbase the search probes, if one is open
+extern Bitbase Bitbases;
+
+} // namespace tiny::tb
@@ -0,0 +1,179 @@
+#include "solve/tb_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <utility>
+
+#include "../core/misc.h"
+
+namespace tiny::tb {
+
+void BitWriter::put(uint64_t v, int n) {
+    for (int i = 0; i < n; ++i) {
+        if (used == 8) {
+            bytes.push_back(0);
+            used = 0;
+        }
+        bytes.back() |= uint8_t(((v >> i) & 1) << used++);
+    }
+}
+
+void BitWriter::put_rice(uint64_t v, int k) {
+    for (uint64_t q = v >> k; q; --q) put(1, 1);
+    put(0, 1);
+    put(v, k);
+}
+
+std::vector<uint8_t>& BitWriter::finish() { return bytes; }
+
+void BitReader::refill() {
+    // Whole bytes at once while 8 of them can be loaded
+    if (end - p >= 8) {
+        uint64_t w;
+        std::memcpy(&w, p, sizeof(w));
+        buf |= w << avail;
+        p += (63 - avail) >> 3;
+        avail |= 56;
+        return;
+    }
+
+    for (; avail <= 56; avail += 8) {
+        if (p < end)
+            buf |= uint64_t(*p++) << avail;
+        else
+            padding += 8;
+    }
+}
+
+uint64_t BitReader::get(int n) {
+    uint64_t v = 0;
+    for (int done = 0; done < n; done += 32) {
+        int m = std::min(n - done, 32);
+        v |= uint64_t(peek(m)) << done;
+        skip(m);
+    }
+    return v;
+}
+
+uint64_t BitReader::get_rice(int k) {
+    // The unary quotient is a run of ones ended by a zero
+    uint64_t q = 0;
+    while (true) {
+        refill();
+        int ones = buf == ~uint64_t(0) ? 64 : lsb64(~buf);
+        if (ones < avail) {
+            q += ones;
+            skip(ones + 1);
+            break;
+        }
+        q += avail;
+        skip(avail);
+        if (overrun()) return 0;
+    }
+    return (q << k) | get(k);
+}
+
+std::vector<uint8_t> Huffman::lengths_for(const std::vector<uint64_t>& freq) {
+    std::vector<uint64_t> f = freq;
+    std::vector<uint8_t>  lengths(f.size(), 0);
+
+    while (true) {
+        // Tree nodes: symbols first, then internal nodes as they are made
+        std::vector<int> parent(2 * f.size(), -1);
+        using Item = std::pair<uint64_t, int>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+
+        for (size_t s = 0; s < f.size(); ++s)
+            if (f[s]) heap.push({f[s], int(s)});
+
+        if (heap.size() == 1) {
+            lengths[heap.top().second] = 1;
+            return lengths;
+        }
+
+        int next = int(f.size());
+        while (heap.size() > 1) {
+            Item a = heap.top();
+            heap.pop();
+            Item b = heap.top();
+            heap.pop();
+            parent[a.second] = parent[b.second] = next;
+            heap.push({a.first + b.first, next++});
+        }
+
+        int maxLength = 0;
+        for (size_t s = 0; s < f.size(); ++s) {
+            int d = 0;
+            for (int n = int(s); f[s] && parent[n] >= 0; n = parent[n]) ++d;
+            lengths[s] = uint8_t(d);
+            maxLength  = std::max(maxLength, d);
+        }
+        if (maxLength <= MaxLength) return lengths;
+
+        // Too deep: flatten the frequencies and try again
+        for (uint64_t& x : f)
+            if (x) x = x / 2 + 1;
+    }
+}
+
+bool Huffman::build(const std::vector<uint8_t>& lengths) {
+    len = lengths;
+    code.assign(len.size(), 0);
+    symbols.clear();
+
+    std::fill(count, count + MaxLength + 1, 0);
+    for (uint8_t l : len) {
+        if (l > MaxLength) return false;
+        if (l) ++count[l];
+    }
+
+    // Canonical codes: consecutive within a length, in symbol order
+    uint32_t c = 0, idx = 0;
+    for (int l = 1; l <= MaxLength; ++l) {
+        first[l] = c;
+        start[l] = idx;
+        for (size_t s = 0; s < len.size(); ++s)
+            if (len[s] == l) {
+                code[s] = c++;
+                symbols.push_back(uint32_t(s));
+            }
+        idx += count[l];
+        if (c > (1u << l)) return false;
+        c <<= 1;
+    }
+
+    // The stream holds the first bit of a code lowest, so the table index
+    // is the code reversed, with any bits after it
+    table.assign(size_t(1) << TableBits, Entry{0, 0});
+    for (size_t s = 0; s < len.size(); ++s) {
+        if (!len[s] || len[s] > TableBits || s > UINT16_MAX) continue;
+        uint32_t rev = 0;
+        for (int i = 0; i < len[s]; ++i) rev |= ((code[s] >> i) & 1) << (len[s] - 1 - i);
+        for (uint32_t rest = 0; rest < (1u << (TableBits - len[s])); ++rest)
+            table[rev | (rest << len[s])] = Entry{uint16_t(s), len[s]};
+    }
+    return true;
+}
+
+void Huffman::put(BitWriter& w, size_t sym) const {
+    for (int i = len[sym] - 1; i >= 0; --i) w.put((code[sym] >> i) & 1, 1);
+}
+
+size_t Huffman::get(BitReader& r) const {
+    const Entry& e = table[r.peek(TableBits)];
+    if (e.length) {
+        r.skip(e.length);
+        return r.overrun() ? SIZE_MAX : e.symbol;
+    }
+
+    uint32_t c = 0;
+    for (int l = 1; l <= MaxLength; ++l) {
+        c = (c << 1) | uint32_t(r.bit());
+        if (c - first[l] < count[l]) return symbols[start[l] + c - first[l]];
+        if (r.overrun()) break;
+    }
+    return SIZE_MAX;
+}
+
+} // namespace tiny::tb
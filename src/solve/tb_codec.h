@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tiny::tb {
+
+// Bit streams for the compressed blocks of a v2 tablebase. Bits are packed
+// from the least significant bit of each byte up.
+class BitWriter {
+   public:
+    // Writes the low n bits of v, lowest first
+    void put(uint64_t v, int n);
+
+    // Writes v as a Rice code with parameter k: v >> k in unary, then the
+    // low k bits
+    void put_rice(uint64_t v, int k);
+
+    // Pads the last byte and returns the stream
+    std::vector<uint8_t>& finish();
+
+   private:
+    std::vector<uint8_t> bytes;
+    int                  used = 8;  // bits used in the last byte
+};
+
+// BitReader keeps up to 64 bits buffered. Reading past the end yields zero
+// bits and sets overrun(), so a damaged file cannot make a probe read out of
+// bounds or loop forever.
+class BitReader {
+   public:
+    BitReader(const uint8_t* begin, const uint8_t* end) : p(begin), end(end) {}
+
+    // The next n <= 32 bits, without consuming them
+    uint32_t peek(int n) {
+        refill();
+        return uint32_t(buf & ((uint64_t(1) << n) - 1));
+    }
+    void skip(int n) {
+        buf >>= n;
+        avail -= n;
+    }
+
+    bool     bit() { return get(1); }
+    uint64_t get(int n);
+    uint64_t get_rice(int k);
+    bool     overrun() const { return avail < padding; }
+
+   private:
+    void refill();
+
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t       buf     = 0;
+    int            avail   = 0;  // bits in buf
+    int            padding = 0;  // of them, zero bits from past the end
+};
+
+// Canonical Huffman code over symbols 0..n-1. It is fully described by the
+// code length of each symbol, so only the lengths are stored.
+class Huffman {
+   public:
+    static constexpr int MaxLength = 24;
+
+    // Code lengths for the given symbol frequencies, none above MaxLength.
+    // Unused symbols get length 0.
+    static std::vector<uint8_t> lengths_for(const std::vector<uint64_t>& freq);
+
+    // Builds the code from its lengths. Returns false if they do not form
+    // a prefix code.
+    bool build(const std::vector<uint8_t>& lengths);
+
+    // Codes are written most significant bit first, as they are decoded
+    void put(BitWriter& w, size_t sym) const;
+
+    // Returns the next symbol, or SIZE_MAX on a bad stream
+    size_t get(BitReader& r) const;
+
+   private:
+    // Codes up to TableBits long are decoded with one table lookup, indexed
+    // by the next TableBits bits of the stream
+    static constexpr int TableBits = 10;
+
+    struct Entry {
+        uint16_t symbol;
+        uint8_t  length;  // 0 if the code is longer than TableBits
+    };
+
+    std::vector<uint8_t>  len;
+    std::vector<uint32_t> code;
+    std::vector<uint32_t> symbols;               // by code length, then symbol
+    uint32_t              first[MaxLength + 1];  // first code of each length
+    uint32_t              start[MaxLength + 1];  // its index in symbols
+    uint32_t              count[MaxLength + 1];  // codes of each length
+    std::vector<Entry>    table;
+};
+
+} // namespace tiny::tb
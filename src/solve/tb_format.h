@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+
+namespace tiny::tb {
+
+// On-disk layout of a tablebase. Keys are Position::canonical_key(), so
+// probes must canonicalize too.
+//
+// Version 1 is a header followed by `count` rows sorted by key.
+//
+// Version 2 splits the sorted rows into blocks of `blockRows` rows, each
+// compressed on its own. A block stores the gaps between consecutive keys
+// as Rice codes, and for each row a Huffman coded value, the WDL and DTM
+// pair, followed by a Huffman coded best move if the row is a win or a loss
+// that is not mate already. After the header come the value table, the
+// move table, the first key and data offset of each block, and the data.
+//
+// Version 3 stores no keys. A minimal perfect hash over the keys gives each
+// one a row, and rows are fixed width: an index into a table of the
+// distinct (WDL, DTM, move) entries, and optionally the top bits of the key
+// as a fingerprint, to turn away most positions that are not in the file.
+// After the header come the entry table, the size of each hash level in
+// bits, the hash bits, the keys the hash left over, and the rows, packed
+// into bits and followed by 8 bytes of padding.
+constexpr char     Magic[8]  = "TNYTB\0\1";
+constexpr uint32_t Version   = 2;
+constexpr uint32_t VersionV1 = 1;
+constexpr uint32_t VersionV3 = 3;
+
+// A WDL bitbase, written next to a tablebase, keeps only the WDL of each
+// position, in 2 bits, in rows indexed by a minimal perfect hash as in
+// version 3. After the header come the hash, as in version 3, and the rows,
+// 32 to a 64-bit word.
+constexpr char     BitbaseMagic[8] = "TNYBB\0\1";
+constexpr uint32_t BitbaseVersion  = 1;
+
+#pragma pack(push, 1)
+struct TBHeader {
+    char     magic[8];
+    uint32_t version;
+    uint64_t count;
+};
+struct TBRow {
+    uint64_t key;
+    uint8_t  wdl;   // 0=Loss,1=Draw,2=Win
+    uint16_t dtm;
+    uint32_t move;
+};
+
+// Version 2
+struct TBHeaderV2 {
+    char     magic[8];
+    uint32_t version;
+    uint64_t count;
+    uint64_t blocks;
+    uint32_t blockRows;
+    uint8_t  riceK;      // Rice parameter of the key gaps
+    uint32_t values;     // entries of the value table
+    uint32_t moves;      // entries of the move table
+    uint64_t dataBytes;  // size of all the blocks
+};
+struct TBValue {
+    uint8_t  wdl;
+    uint16_t dtm;
+    uint8_t  length;  // of its Huffman code
+};
+struct TBMove {
+    uint16_t move;
+    uint8_t  length;
+};
+struct TBBlock {
+    uint64_t firstKey;
+    uint64_t offset;  // from the start of the data
+};
+
+// Version 3
+struct TBHeaderV3 {
+    char     magic[8];
+    uint32_t version;
+    uint64_t count;
+    uint32_t entries;          // of the entry table
+    uint8_t  entryBits;        // of the entry index in a row
+    uint8_t  fingerprintBits;  // 0 to 32
+    uint32_t levels;           // of the hash
+    uint64_t words;            // 64-bit words of hash bits
+    uint64_t fallback;         // keys left over by the hash
+};
+struct TBEntry {
+    uint8_t  wdl;
+    uint16_t dtm;
+    uint16_t move;
+};
+
+// Bitbase
+struct BBHeader {
+    char     magic[8];
+    uint32_t version;
+    uint64_t count;
+    uint8_t  material[4];  // of the solved position, as PositionIndexer counts it
+    uint32_t levels;
+    uint64_t words;
+    uint64_t fallback;
+};
+#pragma pack(pop)
+
+} // namespace tiny::tb
@@ -0,0 +1,103 @@
+#include "solve/tb_mphf.h"
+
+#include <algorithm>
+
+#include "../core/misc.h"
+
+namespace tiny::tb {
+
+namespace {
+
+// Position of key in a level of `size` bits. Keys are hashes already, but
+// each level must scatter them afresh, so they are mixed with the level.
+uint64_t slot(uint64_t key, size_t level, uint64_t size) {
+    uint64_t x = key + (level + 1) * 0x9E3779B97F4A7C15ULL;
+    x          = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x          = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return mul_hi64(x, size);
+}
+
+} // namespace
+
+void Mphf::build(std::vector<uint64_t> keys) {
+    levelBits.clear();
+    bits.clear();
+
+    std::vector<uint64_t> hit, collided;
+    for (int level = 0; level < MaxLevels && !keys.empty(); ++level) {
+        // Twice as many bits as keys, in whole words
+        const uint64_t size   = (2 * keys.size() + 63) / 64 * 64;
+        const uint64_t offset = bits.size() * 64;
+
+        hit.assign(size / 64, 0);
+        collided.assign(size / 64, 0);
+        for (uint64_t k : keys) {
+            const uint64_t s = slot(k, level, size), m = uint64_t(1) << (s % 64);
+            if (hit[s / 64] & m) collided[s / 64] |= m;
+            hit[s / 64] |= m;
+        }
+        for (size_t w = 0; w < hit.size(); ++w) bits.push_back(hit[w] & ~collided[w]);
+        levelBits.push_back(size);
+
+        // The keys that collided go on to the next level
+        keys.erase(std::remove_if(keys.begin(), keys.end(),
+                                  [&](uint64_t k) { return test(offset + slot(k, level, size)); }),
+                   keys.end());
+    }
+
+    std::sort(keys.begin(), keys.end());
+    rest = std::move(keys);
+    index();
+}
+
+bool Mphf::assign(std::vector<uint64_t> levels, std::vector<uint64_t> words,
+                  std::vector<uint64_t> fallback) {
+    uint64_t total = 0;
+    for (uint64_t b : levels) {
+        if (b % 64 || b > words.size() * 64) return false;
+        total += b;
+    }
+    if (levels.size() > MaxLevels || total != words.size() * 64 ||
+        !std::is_sorted(fallback.begin(), fallback.end()))
+        return false;
+
+    levelBits = std::move(levels);
+    bits      = std::move(words);
+    rest      = std::move(fallback);
+    index();
+    return true;
+}
+
+void Mphf::index() {
+    ranks.clear();
+    placed = 0;
+    for (size_t w = 0; w < bits.size(); ++w) {
+        if (w % RankWords == 0) ranks.push_back(placed);
+        placed += size_t(popcount64(bits[w]));
+    }
+    count = placed + rest.size();
+}
+
+size_t Mphf::rank(uint64_t bit) const {
+    const size_t w = bit / 64;
+    size_t       r = ranks[w / RankWords];
+    for (size_t i = w / RankWords * RankWords; i < w; ++i)
+        r += size_t(popcount64(bits[i]));
+    return r + size_t(popcount64(bits[w] & ((uint64_t(1) << (bit % 64)) - 1)));
+}
+
+size_t Mphf::lookup(uint64_t key) const {
+    uint64_t offset = 0;
+    for (size_t level = 0; level < levelBits.size(); ++level) {
+        const uint64_t bit = offset + slot(key, level, levelBits[level]);
+        if (test(bit)) return rank(bit);
+        offset += levelBits[level];
+    }
+
+    auto it = std::lower_bound(rest.begin(), rest.end(), key);
+    if (it == rest.end() || *it != key) return SIZE_MAX;
+    return placed + size_t(it - rest.begin());
+}
+
+} // namespace tiny::tb
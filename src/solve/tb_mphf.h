@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tiny::tb {
+
+// Mphf is a minimal perfect hash function: it maps each of n distinct keys
+// to its own index in [0, n), using about 4 bits per key, so a table can be
+// indexed by key without storing the keys.
+//
+// It is built level by level, as in BBHash. Each level hashes the keys not
+// placed yet into a bit array twice their number, and keeps the bits that
+// only one key hit. The index of a key is the rank of its bit among all
+// the kept bits. The few keys left after MaxLevels are stored as they are.
+class Mphf {
+   public:
+    static constexpr int MaxLevels = 32;
+
+    // Builds the function over keys, which must be distinct
+    void build(std::vector<uint64_t> keys);
+
+    // Sets the function from the parts of a built one. Returns false if
+    // they do not fit together.
+    bool assign(std::vector<uint64_t> levels, std::vector<uint64_t> words,
+                std::vector<uint64_t> fallback);
+
+    // The index of one of the keys. A key that is not one of them gets some
+    // index, or SIZE_MAX.
+    size_t lookup(uint64_t key) const;
+
+    size_t size() const { return count; }
+
+    // The parts: the size of each level in bits, the bits of all levels,
+    // and the keys left over, sorted. These follow the placed keys.
+    const std::vector<uint64_t>& level_bits() const { return levelBits; }
+    const std::vector<uint64_t>& words() const { return bits; }
+    const std::vector<uint64_t>& fallback() const { return rest; }
+
+   private:
+    static constexpr int RankWords = 8;  // words between stored ranks
+
+    bool   test(uint64_t bit) const { return (bits[bit / 64] >> (bit % 64)) & 1; }
+    size_t rank(uint64_t bit) const;
+    void   index();
+
+    std::vector<uint64_t> levelBits, bits, rest;
+    std::vector<uint64_t> ranks;  // set bits before every RankWords words
+    size_t                placed = 0, count = 0;
+};
+
+} // namespace tiny::tb
@@ -0,0 +1,374 @@
+#include "solve/tb_read.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#include "../core/movegen.h"
+#include "solve/tb_format.h"
+
+namespace tiny::tb {
+
+Reader::~Reader() { close(); }
+
+namespace {
+
+// Maps the whole file at path read-only. Returns 0 with the view in p and
+// its size in len, 1 if the file cannot be opened or mapped, and 2 if it is
+// too short for a header. Only the view keeps the file open afterwards.
+int map_file(const std::string& path, void*& p, size_t& len) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return 1;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return 1;
+    }
+    if (uint64_t(size.QuadPart) < sizeof(TBHeader)) {
+        CloseHandle(file);
+        return 2;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void*  view    = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    if (!view) return 1;
+
+    p   = view;
+    len = size_t(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return 1;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return 1;
+    }
+    if (size_t(st.st_size) < sizeof(TBHeader)) {
+        ::close(fd);
+        return 2;
+    }
+
+    void* view = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return 1;
+
+    // Probes jump around the file, read-ahead would be wasted
+    ::madvise(view, size_t(st.st_size), MADV_RANDOM);
+    p   = view;
+    len = size_t(st.st_size);
+#endif
+    return 0;
+}
+
+void unmap_file(void* p, size_t len) {
+#ifdef _WIN32
+    (void) len;
+    UnmapViewOfFile(p);
+#else
+    ::munmap(p, len);
+#endif
+}
+
+}  // namespace
+
+int Reader::open(const std::string& path) {
+    close();
+
+    if (int rc = map_file(path, map, mapLen)) return rc;
+
+    TBHeader h;
+    std::memcpy(&h, map, sizeof(h));
+    if (std::memcmp(h.magic, Magic, sizeof(h.magic)) != 0 ||
+        (h.version != VersionV1 && h.version != Version && h.version != VersionV3)) {
+        close();
+        return 2;
+    }
+
+    version = h.version;
+
+    if (version != VersionV1) {
+        int rc = version == Version ? open_v2() : open_v3();
+        if (rc) close();
+        return rc;
+    }
+
+    if (h.count > (mapLen - sizeof(TBHeader)) / sizeof(TBRow) ||
+        sizeof(TBHeader) + h.count * sizeof(TBRow) != mapLen) {
+        close();
+        return 3;
+    }
+
+    rows  = static_cast<const uint8_t*>(map) + sizeof(TBHeader);
+    count = size_t(h.count);
+    return 0;
+}
+
+// Loads the tables and the block index; the blocks stay in the mapping
+int Reader::open_v2() {
+    TBHeaderV2 h;
+    if (mapLen < sizeof(h)) return 2;
+    std::memcpy(&h, map, sizeof(h));
+
+    if (!h.blockRows || h.riceK > 63 || h.blocks != (h.count + h.blockRows - 1) / h.blockRows)
+        return 2;
+
+    const size_t   tables = size_t(h.values) * sizeof(TBValue) + size_t(h.moves) * sizeof(TBMove);
+    const uint64_t avail  = mapLen - sizeof(h);
+    if (tables > avail || h.blocks > (avail - tables) / sizeof(TBBlock) ||
+        tables + h.blocks * sizeof(TBBlock) + h.dataBytes != avail)
+        return 3;
+
+    const uint8_t* p = static_cast<const uint8_t*>(map) + sizeof(h);
+
+    std::vector<uint8_t> lengths(h.values);
+    for (uint32_t i = 0; i < h.values; ++i, p += sizeof(TBValue)) {
+        TBValue v;
+        std::memcpy(&v, p, sizeof(v));
+        values.push_back({v.wdl, v.dtm});
+        lengths[i] = v.length;
+    }
+    if (!valueCode.build(lengths)) return 2;
+
+    lengths.assign(h.moves, 0);
+    for (uint32_t i = 0; i < h.moves; ++i, p += sizeof(TBMove)) {
+        TBMove m;
+        std::memcpy(&m, p, sizeof(m));
+        moves.push_back(m.move);
+        lengths[i] = m.length;
+    }
+    if (!moveCode.build(lengths)) return 2;
+
+    for (uint64_t i = 0; i < h.blocks; ++i, p += sizeof(TBBlock)) {
+        TBBlock b;
+        std::memcpy(&b, p, sizeof(b));
+        if (b.offset > h.dataBytes || (i && b.offset < blockOffsets.back())) return 2;
+        blockKeys.push_back(b.firstKey);
+        blockOffsets.push_back(b.offset);
+    }
+    blockOffsets.push_back(h.dataBytes);
+
+    rows      = p;
+    count     = size_t(h.count);
+    blockRows = h.blockRows;
+    riceK     = h.riceK;
+    return 0;
+}
+
+// Loads the entry table and the hash; the rows stay in the mapping
+int Reader::open_v3() {
+    TBHeaderV3 h;
+    if (mapLen < sizeof(h)) return 2;
+    std::memcpy(&h, map, sizeof(h));
+
+    const int width = h.entryBits + h.fingerprintBits;
+    if (h.entryBits > 32 || h.fingerprintBits > 32 || h.levels > Mphf::MaxLevels) return 2;
+
+    const uint64_t avail = mapLen - sizeof(h);
+    const uint64_t words = uint64_t(h.levels) + h.words + h.fallback;
+    if (h.entries > avail / sizeof(TBEntry) || words > avail / sizeof(uint64_t) ||
+        h.count > avail * 8 / (width ? width : 1))
+        return 3;
+    const uint64_t data = (h.count * width + 7) / 8 + 8;
+    if (h.entries * sizeof(TBEntry) + words * sizeof(uint64_t) + data != avail) return 3;
+
+    const uint8_t* p = static_cast<const uint8_t*>(map) + sizeof(h);
+
+    entries.resize(h.entries);
+    std::memcpy(entries.data(), p, h.entries * sizeof(TBEntry));
+    p += h.entries * sizeof(TBEntry);
+
+    auto read_words = [&](uint64_t n) {
+        std::vector<uint64_t> v(n);
+        std::memcpy(v.data(), p, n * sizeof(uint64_t));
+        p += n * sizeof(uint64_t);
+        return v;
+    };
+    std::vector<uint64_t> levels   = read_words(h.levels);
+    std::vector<uint64_t> hash     = read_words(h.words);
+    std::vector<uint64_t> fallback = read_words(h.fallback);
+    if (!mphf.assign(std::move(levels), std::move(hash), std::move(fallback)) ||
+        mphf.size() != h.count)
+        return 2;
+
+    rows            = p;
+    count           = size_t(h.count);
+    entryBits       = h.entryBits;
+    fingerprintBits = h.fingerprintBits;
+    return 0;
+}
+
+void Reader::close() {
+    if (map) unmap_file(map, mapLen);
+    map     = nullptr;
+    mapLen  = 0;
+    version = 0;
+    rows    = nullptr;
+    count   = 0;
+    blockKeys.clear();
+    blockOffsets.clear();
+    values.clear();
+    moves.clear();
+    entries.clear();
+    mphf = Mphf();
+}
+
+// Rows are packed, so they are read with memcpy rather than through pointers
+uint64_t Reader::key_at(size_t i) const {
+    uint64_t k;
+    std::memcpy(&k, rows + i * sizeof(TBRow), sizeof(k));
+    return k;
+}
+
+bool Reader::probe(const Position& pos, retro::TBRecord& rec) const {
+    if (!count) return false;
+
+    Symmetry       sym;
+    const uint64_t key = pos.canonical_key(sym);
+
+    const bool found = version == Version     ? find_v2(key, rec)
+                       : version == VersionV3 ? find_v3(key, rec)
+                                              : find_v1(key, rec);
+    if (!found) return false;
+
+    rec.best = transform(rec.best, sym);
+    return true;
+}
+
+bool Reader::find_v1(uint64_t key, retro::TBRecord& rec) const {
+    // Interpolation search: keys are hashes, so they are spread evenly and
+    // the row of a key is well predicted by its value. This takes a couple
+    // of probes where a binary search would take log2(count).
+    size_t lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        const uint64_t klo = key_at(lo), khi = key_at(hi);
+        if (key < klo || key > khi) return false;
+
+        size_t mid = lo;
+        if (khi != klo) mid += size_t(double(key - klo) / double(khi - klo) * double(hi - lo));
+        mid = mid > hi ? hi : mid;
+
+        const uint64_t k = key_at(mid);
+        if (k == key) {
+            TBRow row;
+            std::memcpy(&row, rows + mid * sizeof(TBRow), sizeof(row));
+            rec.key  = row.key;
+            rec.wdl  = retro::WDL(row.wdl);
+            rec.dtm  = row.dtm;
+            rec.best = Move(uint16_t(row.move));
+            return true;
+        }
+        if (k < key)
+            lo = mid + 1;
+        else if (mid == 0)
+            return false;
+        else
+            hi = mid - 1;
+    }
+    return false;
+}
+
+// Decodes the block that may hold key, up to the key
+bool Reader::find_v2(uint64_t key, retro::TBRecord& rec) const {
+    size_t b = std::upper_bound(blockKeys.begin(), blockKeys.end(), key) - blockKeys.begin();
+    if (b-- == 0) return false;
+
+    const size_t n = std::min(size_t(blockRows), count - b * blockRows);
+    BitReader    r(rows + blockOffsets[b], rows + blockOffsets[b + 1]);
+    uint64_t     k = blockKeys[b];
+
+    for (size_t i = 0; i < n && k <= key; ++i) {
+        if (i) k += r.get_rice(riceK) + 1;
+
+        size_t v = valueCode.get(r);
+        if (v == SIZE_MAX) return false;
+
+        const auto [wdl, dtm] = values[v];
+        Move move             = Move(0);
+        if (wdl != uint8_t(retro::WDL::Draw) && dtm > 0) {
+            size_t m = moveCode.get(r);
+            if (m == SIZE_MAX) return false;
+            move = Move(moves[m]);
+        }
+
+        if (r.overrun()) return false;
+        if (k == key) {
+            rec = retro::TBRecord{k, retro::WDL(wdl), dtm, move};
+            return true;
+        }
+    }
+    return false;
+}
+
+// The row the hash gives key, if its fingerprint matches
+bool Reader::find_v3(uint64_t key, retro::TBRecord& rec) const {
+    const size_t i = mphf.lookup(key);
+    if (i >= count) return false;
+
+    // A row is at most 64 bits, so it spans at most 9 bytes; the padding
+    // after the rows keeps the 8 byte load in the file
+    const int      width = entryBits + fingerprintBits;
+    const uint64_t bit   = uint64_t(i) * width;
+    uint64_t       row;
+    std::memcpy(&row, rows + bit / 8, sizeof(row));
+    row >>= bit % 8;
+    if (bit % 8 && width + bit % 8 > 64) row |= uint64_t(rows[bit / 8 + 8]) << (64 - bit % 8);
+    if (width < 64) row &= (uint64_t(1) << width) - 1;
+
+    const uint64_t entry = row & ((uint64_t(1) << entryBits) - 1);
+    if (fingerprintBits && row >> entryBits != key >> (64 - fingerprintBits)) return false;
+    if (entry >= entries.size()) return false;
+
+    const TBEntry& e = entries[entry];
+    rec              = retro::TBRecord{key, retro::WDL(e.wdl), e.dtm, Move(e.move)};
+    return true;
+}
+
+Move Reader::best_move(Position& pos, retro::TBRecord& rec) const {
+    if (!probe(pos, rec)) return Move::none();
+
+    MoveList<LEGAL> moves(pos);
+    if (rec.best && moves.contains(rec.best)) return rec.best;
+
+    // Scores from our side: wins by distance, then draws, then losses
+    auto score = [](const retro::TBRecord& child) {
+        return child.wdl == retro::WDL::Loss   ? 0x20000 - child.dtm
+               : child.wdl == retro::WDL::Draw ? 0x10000
+                                               : child.dtm;
+    };
+
+    Move      best      = Move::none();
+    int       bestScore = -1;
+    StateInfo st;
+
+    for (Move m : moves) {
+        retro::TBRecord child;
+        pos.do_move(m, st);
+        bool found = probe(pos, child);
+        pos.undo_move(m);
+
+        if (found && score(child) > bestScore) {
+            bestScore = score(child);
+            best      = m;
+        }
+    }
+    return best;
+}
+
+} // namespace tiny::tb
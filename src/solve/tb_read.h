@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../core/position.h"
+#include "solve/retro.h"
+#include "solve/tb_codec.h"
+#include "solve/tb_format.h"
+#include "solve/tb_mphf.h"
+
+namespace tiny::tb {
+
+// Reader maps a tablebase file into memory and probes it in place. Nothing
+// is read up front: a probe only faults in the few pages it touches, so the
+// first answer after start-up is as quick as any other. Of a version 2 file,
+// only the block index and the code tables are loaded, and a probe decodes
+// one block. Of a version 3 file, the hash and the entry table are loaded,
+// and a probe reads one row.
+class Reader {
+   public:
+    Reader() = default;
+    ~Reader();
+    Reader(const Reader&)            = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    // Maps the file, version 1, 2 or 3, and validates its header. Returns 0 on
+    // success, 1 if the file cannot be opened or mapped, 2 on a bad header
+    // and 3 if the size does not match the header.
+    int  open(const std::string& path);
+    void close();
+
+    bool   is_open() const { return rows != nullptr; }
+    size_t size() const { return count; }
+
+    // Looks up pos. The key of the record is the canonical one; its best
+    // move, if any, is mapped back to pos. A version 3 file keeps no keys:
+    // a position not in it is only turned away by the fingerprint, if any.
+    bool probe(const Position& pos, retro::TBRecord& rec) const;
+
+    // Returns the best legal move in pos, judged by the records of its
+    // children: the quickest win, else a draw, else the slowest loss. rec
+    // gets the record of pos. Returns Move::none() without legal moves or if
+    // pos is not in the tablebase.
+    Move best_move(Position& pos, retro::TBRecord& rec) const;
+
+   private:
+    int      open_v2();
+    int      open_v3();
+    uint64_t key_at(size_t i) const;
+    bool     find_v1(uint64_t key, retro::TBRecord& rec) const;
+    bool     find_v2(uint64_t key, retro::TBRecord& rec) const;
+    bool     find_v3(uint64_t key, retro::TBRecord& rec) const;
+
+    void*          map     = nullptr;
+    size_t         mapLen  = 0;
+    uint32_t       version = 0;
+    const uint8_t* rows    = nullptr;  // v1 rows, v2 block data or v3 rows
+    size_t         count   = 0;
+
+    // Version 2
+    std::vector<uint64_t>                    blockKeys, blockOffsets;
+    std::vector<std::pair<uint8_t, uint16_t>> values;  // WDL and DTM
+    std::vector<uint16_t>                    moves;
+    Huffman                                  valueCode, moveCode;
+    uint32_t                                 blockRows = 0;
+    int                                      riceK     = 0;
+
+    // Version 3
+    Mphf                 mphf;
+    std::vector<TBEntry> entries;
+    int                  entryBits = 0, fingerprintBits = 0;
+};
+
+} // namespace tiny::tb
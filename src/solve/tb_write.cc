@@ -1,48 +1,226 @@
 #include "solve/tb_write.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "solve/position_indexer.h"
+#include "solve/tb_codec.h"
+#include "solve/tb_format.h"
+#include "solve/tb_mphf.h"
+
 namespace tiny::tb {
 
-#pragma pack(push, 1)
-struct TBHeader {
-    char     magic[8];
-    uint32_t version;
-    uint64_t count;
-};
-struct TBRow {
-    uint64_t key;
-    uint8_t  wdl;   // 0=Loss,1=Draw,2=Win
-    uint16_t dtm;
-    uint32_t move;
-};
-#pragma pack(pop)
-
-int write_binary(const std::string& path,
-                 const std::vector<retro::TBRecord>& recs) {
+namespace {
+
+// Rows per block: a probe decodes up to this many rows, and the index costs
+// 16 bytes per block
+constexpr uint32_t BlockRows = 64;
+
+// Only wins and losses that are not over yet have a best move
+bool has_move(const retro::TBRecord& r) { return r.wdl != retro::WDL::Draw && r.dtm > 0; }
+
+bool write_all(FILE* f, const void* p, size_t bytes) {
+    return bytes == 0 || std::fwrite(p, bytes, 1, f) == 1;
+}
+
+// Writes the parts of mphf, as a version 3 file and a bitbase hold them
+bool write_mphf(FILE* f, const Mphf& mphf) {
+    return write_all(f, mphf.level_bits().data(), mphf.level_bits().size() * sizeof(uint64_t)) &&
+           write_all(f, mphf.words().data(), mphf.words().size() * sizeof(uint64_t)) &&
+           write_all(f, mphf.fallback().data(), mphf.fallback().size() * sizeof(uint64_t));
+}
+
+int write_blocks(const std::string& path, const std::vector<retro::TBRecord>& recs) {
+    // Value and move tables, with the frequencies for their codes
+    std::map<std::pair<uint8_t, uint16_t>, uint32_t> valueId;
+    std::map<uint16_t, uint32_t>                     moveId;
+    for (const auto& r : recs) {
+        valueId.emplace(std::make_pair(uint8_t(r.wdl), r.dtm), 0);
+        if (has_move(r)) moveId.emplace(r.best.raw(), 0);
+    }
+
+    std::vector<TBValue> values;
+    std::vector<TBMove>  moves;
+    for (auto& [v, id] : valueId) {
+        id = uint32_t(values.size());
+        values.push_back({v.first, v.second, 0});
+    }
+    for (auto& [m, id] : moveId) {
+        id = uint32_t(moves.size());
+        moves.push_back({m, 0});
+    }
+
+    std::vector<uint64_t> valueFreq(values.size()), moveFreq(moves.size());
+    for (const auto& r : recs) {
+        ++valueFreq[valueId[{uint8_t(r.wdl), r.dtm}]];
+        if (has_move(r)) ++moveFreq[moveId[r.best.raw()]];
+    }
+
+    std::vector<uint8_t> valueLengths = Huffman::lengths_for(valueFreq);
+    std::vector<uint8_t> moveLengths  = Huffman::lengths_for(moveFreq);
+    Huffman              valueCode, moveCode;
+    valueCode.build(valueLengths);
+    moveCode.build(moveLengths);
+    for (size_t i = 0; i < values.size(); ++i) values[i].length = valueLengths[i];
+    for (size_t i = 0; i < moves.size(); ++i) moves[i].length = moveLengths[i];
+
+    // Keys are uniform hashes, so their gaps are close to geometric and the
+    // best Rice parameter is about log2 of the mean gap
+    int riceK = 0;
+    if (recs.size() > 1) {
+        uint64_t meanGap = (recs.back().key - recs.front().key) / (recs.size() - 1);
+        while (riceK < 63 && (meanGap >> (riceK + 1))) ++riceK;
+    }
+
+    std::vector<TBBlock> blocks;
+    std::vector<uint8_t> data;
+    for (size_t begin = 0; begin < recs.size(); begin += BlockRows) {
+        const size_t end = std::min(recs.size(), begin + BlockRows);
+        blocks.push_back({recs[begin].key, data.size()});
+
+        BitWriter w;
+        for (size_t i = begin; i < end; ++i) {
+            const auto& r = recs[i];
+            if (i > begin) w.put_rice(r.key - recs[i - 1].key - 1, riceK);
+            valueCode.put(w, valueId[{uint8_t(r.wdl), r.dtm}]);
+            if (has_move(r)) moveCode.put(w, moveId[r.best.raw()]);
+        }
+        const std::vector<uint8_t>& bytes = w.finish();
+        data.insert(data.end(), bytes.begin(), bytes.end());
+    }
+
+    TBHeaderV2 h{};
+    std::memcpy(h.magic, Magic, sizeof(h.magic));
+    h.version   = Version;
+    h.count     = recs.size();
+    h.blocks    = blocks.size();
+    h.blockRows = BlockRows;
+    h.riceK     = uint8_t(riceK);
+    h.values    = uint32_t(values.size());
+    h.moves     = uint32_t(moves.size());
+    h.dataBytes = data.size();
+
     FILE* f = std::fopen(path.c_str(), "wb");
     if (!f) return 1;
 
-    TBHeader h{};
-    std::memcpy(h.magic, "TNYTB\0\1", 8);
-    h.version = 1;
-    h.count   = recs.size();
+    bool ok = write_all(f, &h, sizeof(h)) &&
+              write_all(f, values.data(), values.size() * sizeof(TBValue)) &&
+              write_all(f, moves.data(), moves.size() * sizeof(TBMove)) &&
+              write_all(f, blocks.data(), blocks.size() * sizeof(TBBlock)) &&
+              write_all(f, data.data(), data.size());
+
+    if (std::fclose(f) != 0 || !ok) return 2;
+    return 0;
+}
+
+int write_hashed(const std::string& path, const std::vector<retro::TBRecord>& recs,
+                 int fingerprintBits) {
+    std::vector<uint64_t> keys;
+    keys.reserve(recs.size());
+    for (const auto& r : recs) keys.push_back(r.key);
 
-    if (std::fwrite(&h, sizeof(h), 1, f) != 1) { std::fclose(f); return 2; }
+    Mphf mphf;
+    mphf.build(std::move(keys));
 
+    // Table of the distinct entries; rows index it
+    std::map<std::tuple<uint8_t, uint16_t, uint16_t>, uint32_t> entryId;
+    for (const auto& r : recs)
+        entryId.emplace(std::make_tuple(uint8_t(r.wdl), r.dtm, r.best.raw()), 0);
+
+    std::vector<TBEntry> entries;
+    for (auto& [e, id] : entryId) {
+        id = uint32_t(entries.size());
+        entries.push_back({std::get<0>(e), std::get<1>(e), std::get<2>(e)});
+    }
+
+    int entryBits = 0;
+    while ((size_t(1) << entryBits) < entries.size()) ++entryBits;
+    if (entryBits > 32) return 3;
+
+    // Rows in hash order, the entry index low and the fingerprint above it
+    std::vector<uint64_t> rows(recs.size());
     for (const auto& r : recs) {
-        TBRow row{};
-        row.key  = r.key;
-        row.wdl  = static_cast<uint8_t>(r.wdl);
-        row.dtm  = r.dtm;
-        row.move = static_cast<uint32_t>(r.best);
-        if (std::fwrite(&row, sizeof(row), 1, f) != 1) { std::fclose(f); return 3; }
-    }
-    std::fclose(f);
+        uint64_t fingerprint = fingerprintBits ? r.key >> (64 - fingerprintBits) : 0;
+        rows[mphf.lookup(r.key)] =
+            entryId[{uint8_t(r.wdl), r.dtm, r.best.raw()}] | fingerprint << entryBits;
+    }
+
+    BitWriter w;
+    for (uint64_t row : rows) w.put(row, entryBits + fingerprintBits);
+    std::vector<uint8_t>& data = w.finish();
+    data.resize(data.size() + 8, 0);
+
+    TBHeaderV3 h{};
+    std::memcpy(h.magic, Magic, sizeof(h.magic));
+    h.version         = VersionV3;
+    h.count           = recs.size();
+    h.entries         = uint32_t(entries.size());
+    h.entryBits       = uint8_t(entryBits);
+    h.fingerprintBits = uint8_t(fingerprintBits);
+    h.levels          = uint32_t(mphf.level_bits().size());
+    h.words           = mphf.words().size();
+    h.fallback        = mphf.fallback().size();
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return 1;
+
+    bool ok = write_all(f, &h, sizeof(h)) &&
+              write_all(f, entries.data(), entries.size() * sizeof(TBEntry)) &&
+              write_mphf(f, mphf) && write_all(f, data.data(), data.size());
+
+    if (std::fclose(f) != 0 || !ok) return 2;
+    return 0;
+}
+
+} // namespace
+
+int write_binary(const std::string& path, const std::vector<retro::TBRecord>& recs,
+                 const WriteOptions& options) {
+    if (!options.mphf) return write_blocks(path, recs);
+    if (options.fingerprintBits < 0 || options.fingerprintBits > 32) return 3;
+    return write_hashed(path, recs, options.fingerprintBits);
+}
+
+int write_bitbase(const std::string& path, const std::vector<retro::TBRecord>& recs,
+                  const Position& start) {
+    std::vector<uint64_t> keys;
+    keys.reserve(recs.size());
+    for (const auto& r : recs) keys.push_back(r.key);
+
+    Mphf mphf;
+    mphf.build(std::move(keys));
+
+    std::vector<uint64_t> rows((recs.size() + 31) / 32, 0);
+    for (const auto& r : recs) {
+        const size_t i = mphf.lookup(r.key);
+        rows[i / 32] |= uint64_t(r.wdl) << (i % 32 * 2);
+    }
+
+    BBHeader h{};
+    std::memcpy(h.magic, BitbaseMagic, sizeof(h.magic));
+    h.version = BitbaseVersion;
+    h.count   = recs.size();
+    const std::array<int, 4> material = retro::PositionIndexer::material(start);
+    for (int i = 0; i < 4; ++i) h.material[i] = uint8_t(material[i]);
+    h.levels   = uint32_t(mphf.level_bits().size());
+    h.words    = mphf.words().size();
+    h.fallback = mphf.fallback().size();
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return 1;
+
+    bool ok = write_all(f, &h, sizeof(h)) && write_mphf(f, mphf) &&
+              write_all(f, rows.data(), rows.size() * sizeof(uint64_t));
+
+    if (std::fclose(f) != 0 || !ok) return 2;
     return 0;
 }
 
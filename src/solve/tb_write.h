@@ -5,7 +5,27 @@
 
 namespace tiny::tb {
 
+struct WriteOptions {
+    // Writes version 3, indexed by a perfect hash of the keys, instead of
+    // version 2, which stores the keys compressed
+    bool mphf = false;
+
+    // Version 3: bits of each key kept to turn away positions that are not
+    // in the tablebase, 0 to 32. With n bits, one such position in 2^n is
+    // taken for one that is.
+    int fingerprintBits = 16;
+};
+
+// Writes recs, sorted by key, as a tablebase. Returns 0 on success, 1 if
+// the file cannot be created, 2 if writing fails and 3 on bad options.
 int write_binary(const std::string& path,
-                 const std::vector<retro::TBRecord>& recs);
+                 const std::vector<retro::TBRecord>& recs,
+                 const WriteOptions& options = {});
+
+// Writes the WDL of recs as a bitbase (see tb_bitbase.h) for positions
+// with the material of start. Returns as write_binary().
+int write_bitbase(const std::string& path,
+                  const std::vector<retro::TBRecord>& recs,
+                  const Position& start);
 
 } // namespace tiny::tb
@@ -1,12 +1,24 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "core/engine.h"
 #include "core/movegen.h"
+#include "core/misc.h"
 #include "core/position.h"
 #include "core/types.h"
+#include "core/unmovegen.h"
+#include "solve/retro.h"
+#include "solve/tb_bitbase.h"
+#include "solve/tb_read.h"
+#include "solve/tb_write.h"
 
 using namespace tiny;
 
@@ -14,6 +26,103 @@ namespace {
 
 static constexpr Piece Pieces[] = {W_PAWN, W_HORSE, W_FERZ, W_WAZIR, W_KING,
                                    B_PAWN, B_HORSE, B_FERZ, B_WAZIR, B_KING};
+
+// Probes the tablebase at path for one position of every symmetry class
+// reachable from start and compares the answer with the record of the
+// class. Returns the number of classes whose answer differs or is missing.
+size_t check_tablebase(const std::string& path, const Position& start,
+                       const std::vector<retro::TBRecord>& recs) {
+    tb::Reader reader;
+    if (reader.open(path) != 0) return recs.size();
+
+    std::unordered_map<uint64_t, retro::TBRecord> byKey;
+    for (const auto& r : recs) byKey[r.key] = r;
+
+    // Symmetric positions have symmetric children, so one position of each
+    // class is enough to reach them all
+    Symmetry                     sym;
+    std::unordered_set<uint64_t> seen{start.canonical_key(sym)};
+    std::vector<PackedPosition>  queue{start.pack()};
+    size_t                       bad = 0;
+
+    for (size_t i = 0; i < queue.size(); ++i) {
+        Position  pos;
+        StateInfo si;
+        pos.set(queue[i], &si);
+
+        const uint64_t  key = pos.canonical_key(sym);
+        retro::TBRecord got;
+        auto            it = byKey.find(key);
+        if (it == byKey.end() || !reader.probe(pos, got) || got.key != key ||
+            got.wdl != it->second.wdl || got.dtm != it->second.dtm ||
+            got.best != transform(it->second.best, sym))
+            ++bad;
+
+        for (Move m : MoveList<LEGAL>(pos)) {
+            StateInfo st;
+            pos.do_move(m, st);
+            if (seen.insert(pos.canonical_key(sym)).second) queue.push_back(pos.pack());
+            pos.undo_move(m);
+        }
+    }
+
+    return bad + (seen.size() != recs.size());
+}
+
+// Plays random games from the start position and checks generate_unmoves()
+// against the move generator on the way. Every position reached by a legal
+// move must be among the predecessors of the child, and every predecessor
+// of a position must reach it by its legal move. The solver relies on both:
+// a missed predecessor is never solved.
+void check_unmoves(int games, int plies, size_t& positions, size_t& missed, size_t& bogus) {
+    PRNG rng(1070372);
+    positions = missed = bogus = 0;
+
+    for (int g = 0; g < games; ++g) {
+        Position               pos;
+        std::vector<StateInfo> states(plies + 1);
+        pos.set(StartFEN, &states[0]);
+
+        for (int ply = 0; ply < plies; ++ply) {
+            MoveList<LEGAL> moves(pos);
+            if (!moves.size()) break;
+
+            ++positions;
+            const PackedPosition here = pos.pack();
+
+            for (Move m : moves) {
+                StateInfo st, rt;
+                pos.do_move(m, st);
+
+                bool found = false;
+                for (const UnMove& um : UnMoveList(pos)) {
+                    if (um.move != m) continue;
+                    Position prev = pos;
+                    prev.retract(um, &rt);
+                    found |= prev.pack() == here;
+                }
+                missed += !found;
+
+                pos.undo_move(m);
+            }
+
+            for (const UnMove& um : UnMoveList(pos)) {
+                StateInfo rt, st;
+                Position  prev = pos;
+                prev.retract(um, &rt);
+                if (!MoveList<LEGAL>(prev).contains(um.move)) {
+                    ++bogus;
+                    continue;
+                }
+                prev.do_move(um.move, st);
+                bogus += !(prev.pack() == here);
+            }
+
+            pos.do_move(moves.begin()[rng.rand<uint64_t>() % moves.size()], states[ply + 1]);
+        }
+    }
+}
+
 }  // namespace
 
 int main() {
@@ -33,9 +142,6 @@ int main() {
     // Test king attacks from specific squares
     printf("\n=== King Attack Debug ===\n");
 
-    Bitboards::init();
-    Position::init();
-
     // Test king attacks from square 0 (A1) and square 12 (A4)
     Bitboard attacks_a1 = PseudoAttacks[KING][SQ_A1];
     printf("King attacks from A1 (square 0):\n%s\n", Bitboards::pretty(attacks_a1).c_str());
@@ -45,7 +151,7 @@ int main() {
 
     Position    pos;
     StateInfo   si;
-    std::string fen = "fuwk/3p/P3/KWUF w 1";
+    std::string fen = "fhwk/3p/P3/KWHF w 1";
 
     pos.set(fen, &si);
 
@@ -64,4 +170,83 @@ int main() {
     for (Move m : MoveList<LEGAL>(pos)) {
         std::cout << m << '\n';
     }
+
+    // A won bitbase position where the winner is behind in material: the
+    // search must keep the win rather than settle for a draw
+    printf("\n=== Bitbase Win Debug ===\n");
+
+    Position  tbStart;
+    StateInfo tbSi;
+    tbStart.set("k3/4/4/K3 [f] [FW] w 1", &tbSi);
+
+    retro::SolveOptions options;
+    options.progressSeconds = 3600;
+    std::vector<retro::TBRecord> recs = retro::build_wdl_dtm(tbStart, options);
+    std::sort(recs.begin(), recs.end(),
+              [](const retro::TBRecord& a, const retro::TBRecord& b) { return a.key < b.key; });
+
+    const std::string bbPath = "test_bitbase.wdl";
+    if (tb::write_bitbase(bbPath, recs, tbStart) != 0) {
+        printf("cannot write %s\n", bbPath.c_str());
+        return 1;
+    }
+
+    const std::string wonFen = "k2F/4/2f1/KW2 b 1";
+    Engine            engine;
+    Move              best = Move::none();
+    engine.load_bitbase(bbPath);
+    engine.set_position(wonFen, {});
+    engine.set_on_bestmove([&](const SearchResult& r) { best = r.bestMove; });
+
+    Search::LimitsType limits;
+    limits.depth = 4;
+    engine.go(limits);
+    engine.wait_for_search_finished();
+
+    Position   won;
+    StateInfo  wonSi, bestSi;
+    retro::WDL wdl = retro::WDL::Draw;
+    won.set(wonFen, &wonSi);
+    won.do_move(best, bestSi);
+    bool kept = tb::Bitbases.probe(won, wdl) && wdl == retro::WDL::Loss;
+
+    engine.load_bitbase("");
+    std::remove(bbPath.c_str());
+
+    printf("Best move in %s: %s, win %s\n", wonFen.c_str(), to_string(best).c_str(),
+           kept ? "kept" : "LOST");
+
+    // The same records written as a block-compressed version 2 tablebase
+    // must read back unchanged
+    printf("\n=== Tablebase Round Trip Debug ===\n");
+
+    const std::string tbPath = "test_tablebase.tb";
+    size_t            bad    = tb::write_binary(tbPath, recs) == 0
+                                   ? check_tablebase(tbPath, tbStart, recs)
+                                   : recs.size();
+    printf("Version 2: %zu of %zu records differ\n", bad, recs.size());
+
+    // Version 3 keeps no keys, and its rows are bit-packed with or without
+    // a fingerprint
+    for (int fingerprintBits : {0, 16}) {
+        tb::WriteOptions format;
+        format.mphf            = true;
+        format.fingerprintBits = fingerprintBits;
+
+        size_t v3Bad = tb::write_binary(tbPath, recs, format) == 0
+                           ? check_tablebase(tbPath, tbStart, recs)
+                           : recs.size();
+        printf("Version 3, %d fingerprint bits: %zu of %zu records differ\n", fingerprintBits,
+               v3Bad, recs.size());
+        bad += v3Bad;
+    }
+    std::remove(tbPath.c_str());
+
+    printf("\n=== Un-move Debug ===\n");
+
+    size_t positions, missed, bogus;
+    check_unmoves(2000, 80, positions, missed, bogus);
+    printf("%zu positions: %zu predecessors missed, %zu bogus\n", positions, missed, bogus);
+
+    return kept && !bad && !missed && !bogus ? 0 : 1;
 }
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include <map>
 #include <optional>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -24,6 +25,7 @@
 #include "core/types.h"
 #include "helpers.h"
 #include "minmax/minmax.h"
+#include "minmax/thread.h"
 
 using namespace tiny;
 using namespace Colors;
@@ -101,6 +103,10 @@ struct AsyncAI {
     bool                      thinking = false;
     std::future<SearchResult> fut;
 
+    // Searches the human's likely replies while they think, see ponder_replies()
+    bool              pondering = false;
+    std::future<void> ponderFut;
+
     std::optional<Value> lastEval;  // numeric score from search_best_move
 };
 
@@ -686,11 +692,35 @@ static void apply_move_and_advance(AppState* as, Move m) {
     as->legalMoves    = legal_moves(as->pos);  // Update legal moves after the move
 }
 
+// Uses the human's time to search our answers to their likely replies. The
+// TT keeps them for the search after the reply they actually play.
+static void start_pondering_if_needed(AppState* as) {
+    if (as->phase != Phase::Playing) return;
+    if (as->pos.side_to_move() != as->humanSide) return;
+    if (as->ai.pondering || as->ai.thinking) return;
+
+    as->ai.pondering = true;
+
+    Position snapshot = as->pos;
+    Threads.reset_flags(/*ponderMode=*/true);
+    as->ai.ponderFut = std::async(std::launch::async, [snapshot]() mutable {
+        ponder_replies(snapshot, MOVE_NONE, 3);
+    });
+}
+
+static void stop_pondering(AppState* as) {
+    if (!as->ai.pondering) return;
+    Threads.request_stop();
+    as->ai.ponderFut.wait();
+    as->ai.pondering = false;
+}
+
 static void start_ai_thinking_if_needed(AppState* as) {
     if (as->phase != Phase::Playing) return;
     if (as->pos.side_to_move() == as->humanSide) return;
     if (as->ai.thinking) return;
 
+    stop_pondering(as);
     as->ai.thinking = true;
 
     // Snapshot everything the thread needs, _before_ launching it.
@@ -707,6 +737,7 @@ static void check_and_handle_terminal_state(AppState* as) {
     bool  isMate = false, isThree = false;
     Color win = WHITE;
     if (is_terminal(as->pos, isMate, win, isThree)) {
+        stop_pondering(as);
         as->phase      = Phase::GameOver;
         as->winner     = win;
         as->gameResult = isThree  ? GameResult::Draw
@@ -714,6 +745,7 @@ static void check_and_handle_terminal_state(AppState* as) {
                                   : GameResult::Stalemate;
     } else {
         start_ai_thinking_if_needed(as);
+        start_pondering_if_needed(as);
     }
 }
 
@@ -733,6 +765,7 @@ static void maybe_finish_ai(AppState* as) {
 }
 
 static void restart_to_side_select(AppState* as) {
+    stop_pondering(as);
     as->phase       = Phase::SideSelect;
     as->gameResult  = GameResult::None;
     as->ai.thinking = false;
@@ -910,8 +943,7 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
                                      SDL_LOGICAL_PRESENTATION_LETTERBOX);
 
     // Engine init
-    Bitboards::init();
-    Position::init();
+    Threads.set(std::thread::hardware_concurrency());
 
     as->states.clear();
     as->states.emplace_back();
@@ -1019,6 +1051,7 @@ void SDL_AppQuit(void* appstate, SDL_AppResult result) {
     if (!appstate) return;
     AppState* as = (AppState*)appstate;
 
+    stop_pondering(as);
     for (auto& t : as->textures)
         if (t) SDL_DestroyTexture(t);
     if (as->renderer) SDL_DestroyRenderer(as->renderer);